@@ -1,16 +1,148 @@
 #include "Game.h"
 
+// ----- Random Decleration Start -----
+
+static thread_local std::mt19937 randomEngine(static_cast<unsigned int>(time(NULL)));
+
+void seedRandom(unsigned int seed)
+{
+    randomEngine.seed(seed);
+}
+
+float randomUniform()
+{
+    return std::uniform_real_distribution<float>(0.0f, 1.0f)(randomEngine);
+}
+
+int randomInt(int upperBound)
+{
+    return std::uniform_int_distribution<int>(0, upperBound - 1)(randomEngine);
+}
+
+float randomGaussian()
+{
+    return std::normal_distribution<float>(0.0f, 1.0f)(randomEngine);
+}
+
+// ----- Random Decleration End -----
+
+// ----- Distance Decleration Start -----
+
+// Squared euclidean distance, four lanes at a time where SSE is available
+static float squaredDistance(const float *a, const float *b, int size)
+{
+    int i = 0;
+    float total = 0.0f;
+
+#ifdef SDL_SSE_INTRINSICS
+    __m128 sum = _mm_setzero_ps();
+    for (; i + 4 <= size; i += 4)
+    {
+        __m128 difference = _mm_sub_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i));
+        sum = _mm_add_ps(sum, _mm_mul_ps(difference, difference));
+    }
+    float lanes[4];
+    _mm_storeu_ps(lanes, sum);
+    total = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+#endif
+
+    for (; i < size; ++i)
+    {
+        float difference = a[i] - b[i];
+        total += difference * difference;
+    }
+    return total;
+}
+
+// sum[i] += values[i]
+static void accumulate(float *sum, const float *values, int size)
+{
+    int i = 0;
+
+#ifdef SDL_SSE_INTRINSICS
+    for (; i + 4 <= size; i += 4)
+    {
+        _mm_storeu_ps(sum + i, _mm_add_ps(_mm_loadu_ps(sum + i), _mm_loadu_ps(values + i)));
+    }
+#endif
+
+    for (; i < size; ++i)
+    {
+        sum[i] += values[i];
+    }
+}
+
+// sum[i] += (values[i] - mean[i])^2
+static void accumulateSquaredDeviation(float *sum, const float *values, const float *mean, int size)
+{
+    int i = 0;
+
+#ifdef SDL_SSE_INTRINSICS
+    for (; i + 4 <= size; i += 4)
+    {
+        __m128 deviation = _mm_sub_ps(_mm_loadu_ps(values + i), _mm_loadu_ps(mean + i));
+        _mm_storeu_ps(sum + i, _mm_add_ps(_mm_loadu_ps(sum + i), _mm_mul_ps(deviation, deviation)));
+    }
+#endif
+
+    for (; i < size; ++i)
+    {
+        float deviation = values[i] - mean[i];
+        sum[i] += deviation * deviation;
+    }
+}
+
+// ----- Distance Decleration End -----
+
 // ----- Rays Class Decleration Start -----
 
 #define RAYS_NUMBER 10
-void generate_rays(Bird &bird, Ray *rays, Pipe *nearest)
+#define HEADLESS_DELTA_TIME (1.0f / 60.0f)
+#define MAX_FRAME_TIME 0.25f // Longer stalls are dropped instead of replayed as a burst of steps
+#define BEHAVIOUR_SAMPLES 8
+#define BEHAVIOUR_INTERVAL 45
+#define PIPE_SPAWN_INTERVAL 2.8f
+#define PIPE_SCORE 10
+#define BIRD_X 100.0f
+#define BIRD_START_Y 300.0f
+#define BIRD_SIZE 20.0f
+#define BIRD_GRAVITY 800.0f
+#define BIRD_JUMP_STRENGTH -400.0f
+#define PIPE_WIDTH 60.0f
+#define PIPE_GAP_HEIGHT 180.0f
+#define PIPE_X_SPEED 200.0f
+#define PIPE_Y_SPEED 50.0f
+#define VEC_ENV_PIPES 4 // Ring slots per environment, more than are ever on screen at once
+#define IMPACT_TOLERANCE 1e-4f // Seconds past the end of a step a crossing still counts, so rounding never pushes one into the next step
+#define SIMULATION_CHUNK 64 // Birds per parallel task, one word of the alive bitset so threads never share one
+static int lowestSetBit(Uint64 bits)
+{
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanForward64(&index, bits);
+    return (int)index;
+#else
+    return __builtin_ctzll(bits);
+#endif
+}
+
+static int countSetBits(Uint64 bits)
+{
+#ifdef _MSC_VER
+    return (int)__popcnt64(bits);
+#else
+    return __builtin_popcountll(bits);
+#endif
+}
+
+void generate_rays(float xCordinate, float yCordinate, Ray *rays, const PipeView &nearest)
 {
 
     for (int i = 0; i < RAYS_NUMBER; ++i)
     {
         double angle = -M_PI / 2 + ((double)i / (RAYS_NUMBER - 1)) * M_PI;
 
-        Ray ray = {bird.getXCordinate(), bird.getYCordinate(), angle, 0, 0};
+        Ray ray = {xCordinate, yCordinate, angle, 0, 0};
 
         int end_of_screen = 0;
         int object_hit = 0;
@@ -29,9 +161,9 @@ void generate_rays(Bird &bird, Ray *rays, Pipe *nearest)
             if (y_end <= 20 || y_end >= 600 - 20)
                 end_of_screen = 1;
 
-            if (x_end >= nearest->getXCordinate() && x_end <= nearest->getXCordinate() + nearest->getWidth())
+            if (x_end >= nearest.xCordinate && x_end <= nearest.xCordinate + nearest.width)
             {
-                if (y_end <= nearest->getYcordinate() - nearest->getGapHeight() / 2 || y_end >= nearest->getYcordinate() + nearest->getGapHeight() / 2)
+                if (y_end <= nearest.yCordinateGap - nearest.gapHeight / 2 || y_end >= nearest.yCordinateGap + nearest.gapHeight / 2)
                 {
                     object_hit = 1;
                 }
@@ -47,101 +179,368 @@ void generate_rays(Bird &bird, Ray *rays, Pipe *nearest)
 
 // ----- Rays Class Decleration End -----
 
-// ----- Bird Class Decleration Start -----
+// ----- GenomeArena Class Decleration Start -----
+
+#define GENOME_ARENA_CHUNK (2 * 1024 * 1024)
+
+static thread_local GenomeArena *allocationArena = nullptr;
 
-Bird::Bird(int inputNodes, std::vector<int> hiddenNodes, int outputNodes) : xCordinate(100), yCordinate(300), size(20), velocity(0), gravity(800), jumpStrength(-400), score(0), fitness(0), gameOver(false), i_nodes(inputNodes), h_nodes(hiddenNodes), o_nodes(outputNodes)
+GenomeArena::GenomeArena() : chunkIndex(0), chunkUsed(0)
 {
-    weights_hh.resize(h_nodes.size());
-    weights_hh[0].resize(h_nodes[0], std::vector<float>(i_nodes));
-    for (int layer = 1; layer < h_nodes.size(); ++layer)
+    SDL_SetAtomicInt(&references, 1);
+}
+
+GenomeArena::~GenomeArena()
+{
+    for (char *chunk : chunks)
     {
-        weights_hh[layer].resize(h_nodes[layer], std::vector<float>(h_nodes[layer - 1]));
+        SDL_aligned_free(chunk);
     }
+}
 
-    for (int node = 0, layer = 0; node < h_nodes[0]; ++node)
+GenomeBlock *GenomeArena::allocate()
+{
+    if (chunks.empty() || chunkUsed + sizeof(GenomeBlock) > GENOME_ARENA_CHUNK)
     {
-        for (int inp = 0; inp < i_nodes; ++inp)
-        {
-            weights_hh[layer][node][inp] = randomFloat();
-        }
+        if (!chunks.empty())
+            ++chunkIndex;
+        chunkUsed = 0;
+
+        // Chunks are kept across resets, huge-page sized and aligned so the OS can back them with one
+        if (chunkIndex == (int)chunks.size())
+            chunks.push_back(static_cast<char *>(SDL_aligned_alloc(GENOME_ARENA_CHUNK, GENOME_ARENA_CHUNK)));
     }
-    for (int layer = 1; layer < h_nodes.size(); ++layer)
+
+    GenomeBlock *block = reinterpret_cast<GenomeBlock *>(chunks[chunkIndex] + chunkUsed);
+    chunkUsed += sizeof(GenomeBlock);
+
+    block->arena = this;
+    SDL_AtomicIncRef(&references);
+    return block;
+}
+
+void GenomeArena::release()
+{
+    if (SDL_AtomicDecRef(&references))
+        delete this;
+}
+
+bool GenomeArena::isIdle()
+{
+    return SDL_GetAtomicInt(&references) == 1;
+}
+
+void GenomeArena::reset()
+{
+    chunkIndex = 0;
+    chunkUsed = 0;
+}
+
+size_t GenomeArena::getReservedBytes()
+{
+    return chunks.size() * (size_t)GENOME_ARENA_CHUNK;
+}
+
+GenomeArena *GenomeArena::use(GenomeArena *arena)
+{
+    GenomeArena *previous = allocationArena;
+    allocationArena = arena;
+    return previous;
+}
+
+// ----- GenomeArena Class Decleration End -----
+
+// ----- Genome Class Decleration Start -----
+
+GenomeBlock *Genome::allocateBlock()
+{
+    GenomeBlock *block;
+    if (allocationArena)
     {
-        for (int node = 0; node < h_nodes[layer]; ++node)
-        {
-            for (int weight = 0; weight < h_nodes[layer - 1]; ++weight)
-            {
-                weights_hh[layer][node][weight] = randomFloat();
-            }
-        }
+        block = allocationArena->allocate();
+    }
+    else
+    {
+        block = new GenomeBlock;
+        block->arena = nullptr;
     }
+    SDL_SetAtomicInt(&block->references, 1);
+    return block;
+}
+
+void Genome::releaseBlock(GenomeBlock *block)
+{
+    if (!SDL_AtomicDecRef(&block->references))
+        return;
+
+    if (block->arena)
+        block->arena->release();
+    else
+        delete block;
+}
+
+Genome::Genome() : size(0)
+{
+}
 
-    weights_ho.resize(o_nodes, std::vector<float>(h_nodes[h_nodes.size() - 1]));
-    for (int i = 0; i < o_nodes; ++i)
+Genome::Genome(int size) : size(size)
+{
+    blocks.resize((size + GENOME_BLOCK_SIZE - 1) / GENOME_BLOCK_SIZE);
+    for (auto &block : blocks)
     {
-        for (int j = 0; j < h_nodes[h_nodes.size() - 1]; ++j)
-        {
-            weights_ho[i][j] = randomFloat();
-        }
+        block = allocateBlock();
+        std::fill(block->values, block->values + GENOME_BLOCK_SIZE, 0.0f);
+    }
+}
+
+Genome::Genome(const Genome &other) : blocks(other.blocks), size(other.size), deltas(other.deltas)
+{
+    for (auto block : blocks)
+    {
+        SDL_AtomicIncRef(&block->references);
     }
+}
+
+Genome::Genome(Genome &&other) noexcept : blocks(std::move(other.blocks)), size(other.size), deltas(std::move(other.deltas))
+{
+    other.blocks.clear();
+    other.size = 0;
+}
 
-    bias_h.resize(h_nodes.size());
-    for (int layer = 0; layer < h_nodes.size(); ++layer)
+Genome &Genome::operator=(const Genome &other)
+{
+    if (this != &other)
     {
-        bias_h[layer].resize(h_nodes[layer]);
+        Genome copy(other);
+        *this = std::move(copy);
     }
-    for (int layer = 0; layer < h_nodes.size(); ++layer)
+    return *this;
+}
+
+Genome &Genome::operator=(Genome &&other) noexcept
+{
+    if (this != &other)
     {
-        for (int node = 0; node < h_nodes[layer]; ++node)
+        for (auto block : blocks)
         {
-            bias_h[layer][node] = randomFloat();
+            releaseBlock(block);
         }
+        blocks = std::move(other.blocks);
+        size = other.size;
+        deltas = std::move(other.deltas);
+        other.blocks.clear();
+        other.deltas.clear();
+        other.size = 0;
     }
+    return *this;
+}
 
-    bias_o.resize(o_nodes);
-    for (int node = 0; node < o_nodes; ++node)
+Genome::~Genome()
+{
+    for (auto block : blocks)
+    {
+        releaseBlock(block);
+    }
+}
+
+int Genome::getSize() const
+{
+    return size;
+}
+
+float Genome::get(int index) const
+{
+    float value = getStored(index);
+    if (deltas.empty())
+        return value;
+
+    auto delta = std::lower_bound(deltas.begin(), deltas.end(), std::make_pair(index, -INFINITY));
+    if (delta != deltas.end() && delta->first == index)
+        value += delta->second;
+    return value;
+}
+
+float Genome::getStored(int index) const
+{
+    return blocks[index / GENOME_BLOCK_SIZE]->values[index % GENOME_BLOCK_SIZE];
+}
+
+float &Genome::at(int index)
+{
+    materialise();
+    return writeStored(index);
+}
+
+float &Genome::writeStored(int index)
+{
+    GenomeBlock *&block = blocks[index / GENOME_BLOCK_SIZE];
+
+    // Sole owner may write in place, otherwise this genome takes a private copy
+    if (SDL_GetAtomicInt(&block->references) != 1)
+    {
+        GenomeBlock *copy = allocateBlock();
+        std::copy(block->values, block->values + GENOME_BLOCK_SIZE, copy->values);
+        releaseBlock(block);
+        block = copy;
+    }
+
+    return block->values[index % GENOME_BLOCK_SIZE];
+}
+
+void Genome::addDelta(int index, float delta)
+{
+    auto position = std::lower_bound(deltas.begin(), deltas.end(), std::make_pair(index, -INFINITY));
+    if (position != deltas.end() && position->first == index)
+        position->second += delta;
+    else
+        deltas.insert(position, {index, delta});
+
+    // Past an eighth of the genome the list costs more than the blocks it would copy
+    if ((int)deltas.size() > size / 8)
+        materialise();
+}
+
+const std::vector<std::pair<int, float>> &Genome::getDeltas() const
+{
+    return deltas;
+}
+
+void Genome::materialise()
+{
+    if (deltas.empty())
+        return;
+
+    std::vector<std::pair<int, float>> pending;
+    pending.swap(deltas);
+    for (auto &delta : pending)
     {
-        bias_o[node] = randomFloat();
+        float &value = writeStored(delta.first);
+        value = value + delta.second;
     }
 }
 
-void Bird::flap()
+void Genome::relocate(GenomeArena *arena, std::unordered_map<GenomeBlock *, GenomeBlock *> &moved)
 {
-    velocity = jumpStrength;
+    GenomeArena *previous = GenomeArena::use(arena);
+    for (auto &block : blocks)
+    {
+        if (block->arena == arena)
+            continue;
+
+        auto found = moved.find(block);
+        GenomeBlock *copy;
+        if (found != moved.end())
+        {
+            copy = found->second;
+            SDL_AtomicIncRef(&copy->references);
+        }
+        else
+        {
+            copy = allocateBlock();
+            std::copy(block->values, block->values + GENOME_BLOCK_SIZE, copy->values);
+            moved[block] = copy;
+        }
+
+        releaseBlock(block);
+        block = copy;
+    }
+    GenomeArena::use(previous);
+}
+
+int Genome::getBlockCount() const
+{
+    return (int)blocks.size();
+}
+
+int Genome::getSharedBlockCount() const
+{
+    int shared = 0;
+    for (auto block : blocks)
+    {
+        if (SDL_GetAtomicInt(&block->references) > 1)
+            ++shared;
+    }
+    return shared;
 }
 
-void Bird::update(float deltaTime)
+// ----- Genome Class Decleration End -----
+
+// ----- Bird Class Decleration Start -----
+
+Bird::Bird(int inputNodes, std::vector<int> hiddenNodes, int outputNodes) : yCordinate(BIRD_START_Y), score(0), fitness(0), framesAlive(0), gameOver(false), deltaEncoded(false), i_nodes(inputNodes), h_nodes(hiddenNodes), o_nodes(outputNodes), genome(getGenomeSize())
 {
-    velocity += gravity * deltaTime;
-    yCordinate += velocity * deltaTime;
+    for (int index = 0; index < genome.getSize(); ++index)
+    {
+        genome.at(index) = randomFloat();
+    }
 }
 
 void Bird::reset()
 {
-    xCordinate = 100;
-    yCordinate = 300;
-    velocity = 0;
+    yCordinate = BIRD_START_Y;
     score = 0;
     fitness = 0;
+    framesAlive = 0;
     gameOver = false;
+    behaviour.clear();
+}
+
+void Bird::recordFlight(float yCordinate, int score, int fitness, int framesAlive, bool gameOver)
+{
+    this->yCordinate = yCordinate;
+    this->score = score;
+    this->fitness = fitness;
+    this->framesAlive = framesAlive;
+    this->gameOver = gameOver;
 }
 
-SDL_FRect Bird::getRect()
+void Bird::sampleBehaviour(float height)
 {
-    return {xCordinate - (size >> 1), yCordinate - (size >> 1), (float)size, (float)size};
+    if (behaviour.size() < BEHAVIOUR_SAMPLES)
+        behaviour.push_back(height);
 }
 
 std::vector<float> Bird::feedForward(const std::vector<float> &inputs)
 {
+    if (network)
+        return network->activate(inputs);
+
+    // Weights are read in flat order, biases start after the last weight
+    int weight = 0;
+    int bias = getGenomeSize() - o_nodes;
+    for (int layer = 0; layer < (int)h_nodes.size(); ++layer)
+    {
+        bias -= h_nodes[layer];
+    }
+
+    // Deltas are sorted like the reads below, so each cursor only moves forward
+    const std::vector<std::pair<int, float>> &deltas = genome.getDeltas();
+    size_t weightDelta = 0;
+    size_t biasDelta = std::lower_bound(deltas.begin(), deltas.end(), std::make_pair(bias, -INFINITY)) - deltas.begin();
+    auto readWeight = [&](int index)
+    {
+        float value = genome.getStored(index);
+        if (weightDelta < deltas.size() && deltas[weightDelta].first == index)
+            value = value + deltas[weightDelta++].second;
+        return value;
+    };
+    auto readBias = [&](int index)
+    {
+        float value = genome.getStored(index);
+        if (biasDelta < deltas.size() && deltas[biasDelta].first == index)
+            value = value + deltas[biasDelta++].second;
+        return value;
+    };
+
     std::vector<float> hidden_output(h_nodes[0]);
     for (int node = 0; node < h_nodes[0]; ++node)
     {
         float weightedSum = 0.0f;
         for (int prevNode = 0; prevNode < i_nodes; ++prevNode)
         {
-            weightedSum += weights_hh[0][node][prevNode] * inputs[prevNode];
+            weightedSum += readWeight(weight++) * inputs[prevNode];
         }
-        weightedSum += bias_h[0][node];
+        weightedSum += readBias(bias++);
         hidden_output[node] = sigmoid(weightedSum);
     }
     for (int layer = 1; layer < h_nodes.size(); ++layer)
@@ -152,9 +551,9 @@ std::vector<float> Bird::feedForward(const std::vector<float> &inputs)
             float weightedSum = 0.0f;
             for (int prevNode = 0; prevNode < h_nodes[layer - 1]; ++prevNode)
             {
-                weightedSum += weights_hh[layer][node][prevNode] * hidden_output[prevNode];
+                weightedSum += readWeight(weight++) * hidden_output[prevNode];
             }
-            weightedSum += bias_h[layer][node];
+            weightedSum += readBias(bias++);
             hidden_output_layer[node] = sigmoid(weightedSum);
         }
         hidden_output = hidden_output_layer;
@@ -166,9 +565,9 @@ std::vector<float> Bird::feedForward(const std::vector<float> &inputs)
         float weightedSum = 0.0f;
         for (int prevNode = 0; prevNode < h_nodes[(int)h_nodes.size() - 1]; ++prevNode)
         {
-            weightedSum += weights_ho[node][prevNode] * hidden_output[prevNode];
+            weightedSum += readWeight(weight++) * hidden_output[prevNode];
         }
-        weightedSum += bias_o[node];
+        weightedSum += readBias(bias++);
         final_outputs[node] = sigmoid(weightedSum);
     }
 
@@ -177,308 +576,4171 @@ std::vector<float> Bird::feedForward(const std::vector<float> &inputs)
 
 void Bird::mutate(float mutationRate)
 {
-    for (int node = 0, layer = 0; node < h_nodes[layer]; ++node)
+    // Same draw order as the flat layout, untouched blocks stay shared with the parent
+    for (int index = 0; index < genome.getSize(); ++index)
     {
-        for (int prevNode = 0; prevNode < i_nodes; ++prevNode)
+        if (randomChance() < mutationRate)
         {
-            if (randomChance() < mutationRate)
-            {
-                weights_hh[layer][node][prevNode] += randomFloat();
-            }
+            if (deltaEncoded)
+                genome.addDelta(index, randomFloat());
+            else
+                genome.at(index) += randomFloat();
         }
     }
+}
 
-    for (int layer = 1; layer < h_nodes.size(); ++layer)
+int Bird::getGenomeSize()
+{
+    int genomeSize = h_nodes[0] * i_nodes;
+    for (int layer = 1; layer < (int)h_nodes.size(); ++layer)
     {
-        for (int node = 0; node < h_nodes[layer]; ++node)
-        {
-            for (int prevNode = 0; prevNode < h_nodes[layer - 1]; ++prevNode)
-            {
-                if (randomChance() < mutationRate)
-                {
-                    weights_hh[layer][node][prevNode] += randomFloat();
-                }
-            }
-        }
+        genomeSize += h_nodes[layer] * h_nodes[layer - 1];
     }
+    genomeSize += o_nodes * h_nodes[(int)h_nodes.size() - 1];
+    for (int layer = 0; layer < (int)h_nodes.size(); ++layer)
+    {
+        genomeSize += h_nodes[layer];
+    }
+    return genomeSize + o_nodes;
+}
 
-    for (int node = 0; node < o_nodes; ++node)
+std::vector<int> Bird::getWeightLayerSizes()
+{
+    std::vector<int> sizes;
+    sizes.push_back(h_nodes[0] * i_nodes);
+    for (int layer = 1; layer < (int)h_nodes.size(); ++layer)
     {
-        for (int prevNode = 0; prevNode < h_nodes[(int)h_nodes.size() - 1]; ++prevNode)
-        {
-            if (randomChance() < mutationRate)
-            {
-                weights_ho[node][prevNode] += randomFloat();
-            }
-        }
+        sizes.push_back(h_nodes[layer] * h_nodes[layer - 1]);
     }
+    sizes.push_back(o_nodes * h_nodes[(int)h_nodes.size() - 1]);
+    return sizes;
+}
 
-    for (int layer = 0; layer < (int)h_nodes.size(); ++layer)
+std::vector<float> Bird::getGenome()
+{
+    std::vector<float> values(genome.getSize());
+    for (int index = 0; index < genome.getSize(); ++index)
     {
-        for (int node = 0; node < h_nodes[layer]; ++node)
+        values[index] = genome.get(index);
+    }
+    return values;
+}
+
+void Bird::setGenome(const std::vector<float> &values)
+{
+    Genome replacement(genome.getSize());
+    for (int index = 0; index < replacement.getSize(); ++index)
+    {
+        replacement.at(index) = values[index];
+    }
+    genome = std::move(replacement);
+}
+
+Uint64 Bird::getGenomeHash()
+{
+    // FNV-1a over the raw bits, so any change to any parameter changes the hash
+    Uint64 hash = 0xCBF29CE484222325ull;
+    auto mix = [&hash](Uint32 bits)
+    {
+        for (int byte = 0; byte < 4; ++byte)
         {
-            if (randomChance() < mutationRate)
-            {
-                bias_h[layer][node] += randomFloat();
-            }
+            hash ^= (bits >> (byte * 8)) & 0xFF;
+            hash *= 0x100000001B3ull;
         }
-    }
+    };
 
-    for (int node = 0; node < o_nodes; ++node)
+    if (network)
     {
-        if (randomChance() < mutationRate)
+        for (auto &connection : network->getGenome().getConnections())
         {
-            bias_o[node] += randomFloat();
+            Uint32 weightBits;
+            SDL_memcpy(&weightBits, &connection.weight, sizeof(weightBits));
+            mix((Uint32)connection.innovation);
+            mix(weightBits);
+            mix(connection.enabled);
         }
+        return hash;
+    }
+
+    for (float value : getGenome())
+    {
+        Uint32 bits;
+        SDL_memcpy(&bits, &value, sizeof(bits));
+        mix(bits);
     }
+    return hash;
+}
+
+void Bird::relocateGenome(GenomeArena *arena, std::unordered_map<GenomeBlock *, GenomeBlock *> &moved)
+{
+    genome.relocate(arena, moved);
+}
+
+void Bird::setDeltaEncoded(bool enabled)
+{
+    deltaEncoded = enabled;
+    if (!enabled)
+        genome.materialise();
+}
+
+std::shared_ptr<const NeatNetwork> Bird::getNetwork()
+{
+    return network;
+}
+
+void Bird::setNetwork(std::shared_ptr<const NeatNetwork> network)
+{
+    this->network = network;
+}
+
+float Bird::sigmoid(float x)
+{
+    return 1.0f / (1.0f + std::exp(-x));
+}
+
+float Bird::randomFloat()
+{
+    return randomUniform() * 2.0f - 1.0f;
+}
+
+float Bird::randomChance()
+{
+    return randomUniform();
+}
+
+int Bird::getFitness()
+{
+    return fitness;
+}
+
+bool Bird::getGameOver()
+{
+    return gameOver;
+}
+
+void Bird::setGameOver(bool condition)
+{
+    gameOver = condition;
+}
+
+float Bird::getYCordinate()
+{
+    return yCordinate;
+}
+
+void Bird::setFitness(int value)
+{
+    fitness = value;
+}
+
+int Bird::getScore()
+{
+    return score;
+}
+
+int Bird::getFramesAlive()
+{
+    return framesAlive;
+}
+
+std::vector<float> Bird::getBehaviour()
+{
+    // A bird that died early keeps its last height for the rest of the trajectory
+    std::vector<float> descriptor = behaviour;
+    descriptor.resize(BEHAVIOUR_SAMPLES, behaviour.empty() ? yCordinate / 600.0f : behaviour.back());
+    return descriptor;
+}
+
+void Bird::setBehaviour(const std::vector<float> &descriptor)
+{
+    behaviour = descriptor;
+}
+
+// ----- Bird Class Decleration End -----
+
+// ----- BirdStates Class Decleration Start -----
+
+void BirdStates::reset(int count)
+{
+    y.resize(count);
+    previousY.resize(count);
+    velocity.resize(count);
+    score.resize(count);
+    fitness.resize(count);
+    framesAlive.resize(count);
+
+    // Bits past the last slot stay clear, so whole words can be scanned
+    alive.assign((count + 63) / 64, 0);
+    liveWords.clear();
+    aliveCount = 0;
+    for (int slot = 0; slot < count; ++slot)
+    {
+        resetSlot(slot);
+    }
+}
+
+void BirdStates::resetSlot(int slot)
+{
+    y[slot] = BIRD_START_Y;
+    previousY[slot] = BIRD_START_Y;
+    velocity[slot] = 0.0f;
+    score[slot] = 0;
+    fitness[slot] = 0;
+    framesAlive[slot] = 0;
+
+    Uint64 &word = alive[slot >> 6];
+    Uint64 bit = (Uint64)1 << (slot & 63);
+    if (word & bit)
+        return;
+
+    if (word == 0)
+        liveWords.push_back(slot >> 6);
+    word |= bit;
+    ++aliveCount;
+}
+
+void BirdStates::compact()
+{
+    aliveCount = 0;
+    int kept = 0;
+    for (int word : liveWords)
+    {
+        if (alive[word] == 0)
+            continue;
+        aliveCount += countSetBits(alive[word]);
+        liveWords[kept++] = word;
+    }
+    liveWords.resize(kept);
+}
+
+int BirdStates::size() const
+{
+    return (int)y.size();
+}
+
+bool BirdStates::isAlive(int slot) const
+{
+    return (alive[slot >> 6] >> (slot & 63)) & 1;
+}
+
+SDL_FRect BirdStates::getRect(int slot) const
+{
+    return {BIRD_X - BIRD_SIZE / 2, y[slot] - BIRD_SIZE / 2, BIRD_SIZE, BIRD_SIZE};
+}
+
+SDL_FRect BirdStates::getInterpolatedRect(int slot, float alpha) const
+{
+    float height = previousY[slot] + (y[slot] - previousY[slot]) * alpha;
+    return {BIRD_X - BIRD_SIZE / 2, height - BIRD_SIZE / 2, BIRD_SIZE, BIRD_SIZE};
+}
+
+// ----- BirdStates Class Decleration End -----
+
+// ----- EliteArchive Class Decleration Start -----
+
+EliteArchive::EliteArchive(int capacity) : capacity(capacity), insertions(0)
+{
+    elites.reserve(capacity + 1);
+}
+
+bool EliteArchive::offer(const Bird &bird)
+{
+    Bird candidate = bird;
+    if ((int)elites.size() == capacity && candidate.getFitness() <= elites.back().getFitness())
+        return false;
+
+    int position = 0;
+    while (position < (int)elites.size() && elites[position].getFitness() >= candidate.getFitness())
+    {
+        ++position;
+    }
+    elites.insert(elites.begin() + position, candidate);
+    if ((int)elites.size() > capacity)
+        elites.pop_back();
+
+    ++insertions;
+    return true;
+}
+
+Bird &EliteArchive::select()
+{
+    // Binary tournament, so fitter elites breed more often
+    Bird &a = elites[randomInt((int)elites.size())];
+    Bird &b = elites[randomInt((int)elites.size())];
+    return a.getFitness() >= b.getFitness() ? a : b;
+}
+
+int EliteArchive::getBestFitness()
+{
+    return elites.empty() ? 0 : elites.front().getFitness();
+}
+
+int EliteArchive::getEntryFitness()
+{
+    return (int)elites.size() < capacity ? 0 : elites.back().getFitness() + 1;
+}
+
+bool EliteArchive::isEmpty()
+{
+    return elites.empty();
+}
+
+int EliteArchive::getSize()
+{
+    return (int)elites.size();
+}
+
+int EliteArchive::getInsertions()
+{
+    return insertions;
+}
+
+// ----- EliteArchive Class Decleration End -----
+
+// ----- Neat Class Decleration Start -----
+
+#define NEAT_INPUT 0
+#define NEAT_BIAS 1
+#define NEAT_OUTPUT 2
+#define NEAT_HIDDEN 3
+
+NeatInnovations::NeatInnovations(int inputs, int outputs) : nextInnovation(0), nextNode(inputs + 1 + outputs)
+{
+}
+
+int NeatInnovations::getConnection(int from, int to)
+{
+    auto found = connections.find({from, to});
+    if (found != connections.end())
+        return found->second;
+
+    connections[{from, to}] = nextInnovation;
+    return nextInnovation++;
+}
+
+int NeatInnovations::getSplitNode(int innovation)
+{
+    auto found = splits.find(innovation);
+    if (found != splits.end())
+        return found->second;
+
+    splits[innovation] = nextNode;
+    return nextNode++;
+}
+
+int NeatInnovations::createNode()
+{
+    return nextNode++;
+}
+
+NeatGenome::NeatGenome()
+{
+}
+
+// Minimal topology : every input and the bias wired straight to every output
+NeatGenome::NeatGenome(int inputs, int outputs, NeatInnovations &innovations)
+{
+    for (int i = 0; i < inputs; ++i)
+    {
+        nodes.push_back({i, NEAT_INPUT});
+    }
+    nodes.push_back({inputs, NEAT_BIAS});
+    for (int o = 0; o < outputs; ++o)
+    {
+        nodes.push_back({inputs + 1 + o, NEAT_OUTPUT});
+    }
+
+    for (int o = 0; o < outputs; ++o)
+    {
+        for (int i = 0; i <= inputs; ++i)
+        {
+            addConnection({innovations.getConnection(i, inputs + 1 + o), i, inputs + 1 + o, randomGaussian(), true});
+        }
+    }
+}
+
+bool NeatGenome::hasNode(int id)
+{
+    for (auto &node : nodes)
+    {
+        if (node.id == id)
+            return true;
+    }
+    return false;
+}
+
+bool NeatGenome::createsCycle(int from, int to)
+{
+    // A new edge from -> to closes a loop when "to" already reaches "from"
+    std::vector<int> stack = {to};
+    std::vector<int> visited;
+    while (!stack.empty())
+    {
+        int node = stack.back();
+        stack.pop_back();
+        if (node == from)
+            return true;
+        if (std::find(visited.begin(), visited.end(), node) != visited.end())
+            continue;
+        visited.push_back(node);
+
+        for (auto &connection : connections)
+        {
+            if (connection.enabled && connection.from == node)
+                stack.push_back(connection.to);
+        }
+    }
+    return false;
+}
+
+void NeatGenome::addConnection(NeatConnectionGene connection)
+{
+    auto position = connections.begin();
+    while (position != connections.end() && position->innovation < connection.innovation)
+    {
+        ++position;
+    }
+    connections.insert(position, connection);
+}
+
+void NeatGenome::mutate(NeatInnovations &innovations)
+{
+    for (auto &connection : connections)
+    {
+        if (randomUniform() < 0.8f)
+        {
+            if (randomUniform() < 0.9f)
+                connection.weight += randomGaussian() * 0.5f;
+            else
+                connection.weight = randomGaussian();
+            connection.weight = std::max(-8.0f, std::min(8.0f, connection.weight));
+        }
+    }
+
+    if (randomUniform() < 0.05f)
+    {
+        for (int attempt = 0; attempt < 20; ++attempt)
+        {
+            NeatNodeGene &from = nodes[randomInt((int)nodes.size())];
+            NeatNodeGene &to = nodes[randomInt((int)nodes.size())];
+            if (from.kind == NEAT_OUTPUT || to.kind == NEAT_INPUT || to.kind == NEAT_BIAS)
+                continue;
+
+            int innovation = innovations.getConnection(from.id, to.id);
+            bool exists = false;
+            for (auto &connection : connections)
+            {
+                exists |= connection.innovation == innovation;
+            }
+            if (exists || createsCycle(from.id, to.id))
+                continue;
+
+            addConnection({innovation, from.id, to.id, randomGaussian(), true});
+            break;
+        }
+    }
+
+    if (randomUniform() < 0.03f && !connections.empty())
+    {
+        NeatConnectionGene split = connections[randomInt((int)connections.size())];
+        if (split.enabled)
+        {
+            for (auto &connection : connections)
+            {
+                if (connection.innovation == split.innovation)
+                    connection.enabled = false;
+            }
+
+            int node = innovations.getSplitNode(split.innovation);
+            if (hasNode(node))
+                node = innovations.createNode();
+            nodes.push_back({node, NEAT_HIDDEN});
+
+            // Weight 1 in, old weight out, so the split starts close to the old behaviour
+            addConnection({innovations.getConnection(split.from, node), split.from, node, 1.0f, true});
+            addConnection({innovations.getConnection(node, split.to), node, split.to, split.weight, true});
+        }
+    }
+
+    if (randomUniform() < 0.01f && !connections.empty())
+    {
+        NeatConnectionGene &connection = connections[randomInt((int)connections.size())];
+        if (!connection.enabled && !createsCycle(connection.from, connection.to))
+            connection.enabled = true;
+    }
+}
+
+float NeatGenome::distance(const NeatGenome &other)
+{
+    int mismatched = 0;
+    int matching = 0;
+    float weightDifference = 0.0f;
+
+    size_t a = 0, b = 0;
+    while (a < connections.size() && b < other.connections.size())
+    {
+        if (connections[a].innovation == other.connections[b].innovation)
+        {
+            weightDifference += std::fabs(connections[a].weight - other.connections[b].weight);
+            ++matching;
+            ++a;
+            ++b;
+        }
+        else if (connections[a].innovation < other.connections[b].innovation)
+        {
+            ++mismatched;
+            ++a;
+        }
+        else
+        {
+            ++mismatched;
+            ++b;
+        }
+    }
+    mismatched += (int)(connections.size() - a) + (int)(other.connections.size() - b);
+
+    // Disjoint and excess genes weigh the same here
+    float genes = std::max(connections.size(), other.connections.size()) < 20 ? 1.0f : (float)std::max(connections.size(), other.connections.size());
+    return mismatched / genes + 0.4f * (matching ? weightDifference / matching : 0.0f);
+}
+
+NeatGenome NeatGenome::crossover(const NeatGenome &fitter, const NeatGenome &other)
+{
+    // Structure comes from the fitter parent only, so the child stays acyclic
+    NeatGenome child;
+    child.nodes = fitter.nodes;
+
+    size_t b = 0;
+    for (auto gene : fitter.connections)
+    {
+        while (b < other.connections.size() && other.connections[b].innovation < gene.innovation)
+        {
+            ++b;
+        }
+
+        if (b < other.connections.size() && other.connections[b].innovation == gene.innovation)
+        {
+            if (randomUniform() < 0.5f)
+                gene.weight = other.connections[b].weight;
+            if ((!gene.enabled || !other.connections[b].enabled) && randomUniform() < 0.75f)
+                gene.enabled = false;
+        }
+        child.connections.push_back(gene);
+    }
+
+    return child;
+}
+
+const std::vector<NeatNodeGene> &NeatGenome::getNodes() const
+{
+    return nodes;
+}
+
+const std::vector<NeatConnectionGene> &NeatGenome::getConnections() const
+{
+    return connections;
+}
+
+int NeatGenome::getEnabledConnectionCount() const
+{
+    int count = 0;
+    for (auto &connection : connections)
+    {
+        count += connection.enabled;
+    }
+    return count;
+}
+
+NeatNetwork::NeatNetwork(const NeatGenome &genome) : genome(genome), inputCount(0)
+{
+    const std::vector<NeatNodeGene> &nodes = genome.getNodes();
+    valueCount = (int)nodes.size();
+
+    int maxId = 0;
+    for (auto &node : nodes)
+    {
+        maxId = std::max(maxId, node.id);
+    }
+    std::vector<int> slotOf(maxId + 1, -1);
+    for (int slot = 0; slot < valueCount; ++slot)
+    {
+        slotOf[nodes[slot].id] = slot;
+        if (nodes[slot].kind == NEAT_INPUT)
+            ++inputCount;
+        if (nodes[slot].kind == NEAT_OUTPUT)
+            outputSlots.push_back(slot);
+    }
+
+    std::vector<std::vector<std::pair<int, float>>> incoming(valueCount);
+    std::vector<int> pending(valueCount, 0);
+    for (auto &connection : genome.getConnections())
+    {
+        if (!connection.enabled)
+            continue;
+        incoming[slotOf[connection.to]].push_back({slotOf[connection.from], connection.weight});
+        ++pending[slotOf[connection.to]];
+    }
+
+    std::vector<std::vector<int>> outgoing(valueCount);
+    for (int slot = 0; slot < valueCount; ++slot)
+    {
+        for (auto &edge : incoming[slot])
+        {
+            outgoing[edge.first].push_back(slot);
+        }
+    }
+
+    // Kahn's algorithm, each node is emitted once all of its sources are
+    std::vector<int> ready;
+    for (int slot = 0; slot < valueCount; ++slot)
+    {
+        if (pending[slot] == 0)
+            ready.push_back(slot);
+    }
+    for (size_t next = 0; next < ready.size(); ++next)
+    {
+        int slot = ready[next];
+        if (nodes[slot].kind != NEAT_INPUT && nodes[slot].kind != NEAT_BIAS)
+        {
+            NeatInstruction instruction = {slot, (int)sources.size(), 0};
+            for (auto &edge : incoming[slot])
+            {
+                sources.push_back(edge.first);
+                weights.push_back(edge.second);
+            }
+            instruction.end = (int)sources.size();
+            instructions.push_back(instruction);
+        }
+
+        for (int target : outgoing[slot])
+        {
+            if (--pending[target] == 0)
+                ready.push_back(target);
+        }
+    }
+}
+
+std::vector<float> NeatNetwork::activate(const std::vector<float> &inputs) const
+{
+    std::vector<float> values(valueCount, 0.0f);
+    for (int i = 0; i < inputCount; ++i)
+    {
+        values[i] = inputs[i];
+    }
+    values[inputCount] = 1.0f; // Bias
+
+    // Straight-line pass over the compiled instructions, no graph walking
+    for (auto &instruction : instructions)
+    {
+        float weightedSum = 0.0f;
+        for (int c = instruction.begin; c < instruction.end; ++c)
+        {
+            weightedSum += weights[c] * values[sources[c]];
+        }
+        values[instruction.node] = 1.0f / (1.0f + std::exp(-weightedSum));
+    }
+
+    std::vector<float> outputs(outputSlots.size());
+    for (size_t o = 0; o < outputSlots.size(); ++o)
+    {
+        outputs[o] = values[outputSlots[o]];
+    }
+    return outputs;
+}
+
+const NeatGenome &NeatNetwork::getGenome() const
+{
+    return genome;
+}
+
+int NeatNetwork::getConnectionCount() const
+{
+    return (int)weights.size();
+}
+
+// ----- Neat Class Decleration End -----
+
+// ----- Optimiser Class Decleration Start -----
+
+void Optimiser::proposeOffspring(std::vector<Bird> &birds)
+{
+    evolve(birds);
+}
+
+int Optimiser::getEliteCount()
+{
+    return 0;
+}
+
+bool Optimiser::ownsEncoding()
+{
+    return false;
+}
+
+void Optimiser::setThreadPool(ThreadPool *)
+{
+}
+
+ElitistOptimiser::ElitistOptimiser(float mutationRate) : mutationRate(mutationRate)
+{
+}
+
+void ElitistOptimiser::initialise(std::vector<Bird> &)
+{
+}
+
+void ElitistOptimiser::evolve(std::vector<Bird> &population)
+{
+    int populationSize = (int)population.size();
+    std::vector<int> topElitism(3, 0);
+    for (int i = 0; i < populationSize; ++i)
+    {
+        if (population[i].getFitness() > population[topElitism[0]].getFitness())
+        {
+            topElitism[2] = topElitism[1];
+            topElitism[1] = topElitism[0];
+            topElitism[0] = i;
+        }
+        else if (population[i].getFitness() > population[topElitism[1]].getFitness())
+        {
+            topElitism[2] = topElitism[1];
+            topElitism[1] = i;
+        }
+        else if (population[i].getFitness() > population[topElitism[2]].getFitness())
+        {
+            topElitism[2] = i;
+        }
+    }
+
+    std::vector<Bird> newGeneration;
+    newGeneration.reserve(populationSize);
+
+    int start = 0;
+
+    Bird elite1 = population[topElitism[0]];
+    elite1.reset();
+    newGeneration.push_back(elite1);
+    ++start;
+
+    for (; start < populationSize / 3; ++start)
+    {
+        Bird child = elite1;
+        child.mutate(mutationRate);
+        newGeneration.push_back(child);
+    }
+
+    Bird elite2 = population[topElitism[1]];
+    elite2.reset();
+    newGeneration.push_back(elite2);
+    ++start;
+
+    for (; start < (populationSize / 3) * 2; ++start)
+    {
+        Bird child = elite2;
+        child.mutate(mutationRate);
+        newGeneration.push_back(child);
+    }
+
+    Bird elite3 = population[topElitism[2]];
+    elite3.reset();
+    newGeneration.push_back(elite3);
+    ++start;
+
+    for (; start < populationSize; ++start)
+    {
+        Bird child = elite3;
+        child.mutate(mutationRate);
+        newGeneration.push_back(child);
+    }
+
+    population = newGeneration;
+}
+
+const char *ElitistOptimiser::getName()
+{
+    return "elitist";
+}
+
+int ElitistOptimiser::getEliteCount()
+{
+    // Only the top three birds are copied into the next generation
+    return 3;
+}
+
+// Birds sorted best first, ties keep their slot order
+static std::vector<int> rankByFitness(std::vector<Bird> &birds)
+{
+    std::vector<int> order(birds.size());
+    for (int i = 0; i < (int)order.size(); ++i)
+    {
+        order[i] = i;
+    }
+    std::stable_sort(order.begin(), order.end(), [&birds](int a, int b)
+                     { return birds[a].getFitness() > birds[b].getFitness(); });
+    return order;
+}
+
+OpenAIESOptimiser::OpenAIESOptimiser(float sigma, float learningRate) : sigma(sigma), learningRate(learningRate), weightDecay(0.005f), steps(0)
+{
+}
+
+void OpenAIESOptimiser::initialise(std::vector<Bird> &birds)
+{
+    mean = birds[0].getGenome();
+    adamM.assign(mean.size(), 0.0f);
+    adamV.assign(mean.size(), 0.0f);
+    sample(birds);
+}
+
+void OpenAIESOptimiser::sample(std::vector<Bird> &birds)
+{
+    // Antithetic pairs : bird 2k flies mean + sigma * eps, bird 2k + 1 flies mean - sigma * eps
+    std::vector<float> genome(mean.size());
+    std::vector<float> noise(mean.size());
+    for (int i = 0; i < (int)birds.size(); ++i)
+    {
+        if (i % 2 == 0)
+        {
+            for (auto &value : noise)
+                value = randomGaussian();
+        }
+
+        float sign = i % 2 == 0 ? 1.0f : -1.0f;
+        for (int j = 0; j < (int)mean.size(); ++j)
+        {
+            genome[j] = mean[j] + sign * sigma * noise[j];
+        }
+
+        birds[i].setGenome(genome);
+        birds[i].reset();
+    }
+}
+
+void OpenAIESOptimiser::evolve(std::vector<Bird> &birds)
+{
+    int count = (int)birds.size();
+    int dimensions = (int)mean.size();
+
+    // Centred ranks in [-0.5, 0.5] make the update invariant to the fitness scale
+    std::vector<int> order = rankByFitness(birds);
+    std::vector<float> utility(count, 0.0f);
+    for (int first = 0; first < count;)
+    {
+        // Tied birds share their average rank, otherwise slot order would leak into the gradient
+        int last = first;
+        while (last + 1 < count && birds[order[last + 1]].getFitness() == birds[order[first]].getFitness())
+        {
+            ++last;
+        }
+        float rank = (first + last) / 2.0f;
+        for (int i = first; i <= last; ++i)
+        {
+            utility[order[i]] = count > 1 ? 0.5f - rank / (count - 1) : 0.0f;
+        }
+        first = last + 1;
+    }
+
+    // The perturbation is read back from the genome, so immigrants are handled like any other sample
+    std::vector<float> gradient(dimensions, 0.0f);
+    for (int i = 0; i < count; ++i)
+    {
+        std::vector<float> genome = birds[i].getGenome();
+        for (int j = 0; j < dimensions; ++j)
+        {
+            gradient[j] += utility[i] * (genome[j] - mean[j]);
+        }
+    }
+
+    ++steps;
+    const float beta1 = 0.9f, beta2 = 0.999f, epsilon = 1e-8f;
+    float correction = learningRate * std::sqrt(1.0f - std::pow(beta2, (float)steps)) / (1.0f - std::pow(beta1, (float)steps));
+    for (int j = 0; j < dimensions; ++j)
+    {
+        // Ascent direction, plus L2 decay to keep the weights out of sigmoid saturation
+        float g = gradient[j] / (count * sigma * sigma) - weightDecay * mean[j];
+        adamM[j] = beta1 * adamM[j] + (1.0f - beta1) * g;
+        adamV[j] = beta2 * adamV[j] + (1.0f - beta2) * g * g;
+        mean[j] += correction * adamM[j] / (std::sqrt(adamV[j]) + epsilon);
+    }
+
+    sample(birds);
+}
+
+const char *OpenAIESOptimiser::getName()
+{
+    return "openai-es";
+}
+
+SepCMAESOptimiser::SepCMAESOptimiser(float sigma) : sigma(sigma), generation(0)
+{
+}
+
+void SepCMAESOptimiser::initialise(std::vector<Bird> &birds)
+{
+    mean = birds[0].getGenome();
+    variance.assign(mean.size(), 1.0f);
+    pathSigma.assign(mean.size(), 0.0f);
+    pathC.assign(mean.size(), 0.0f);
+    sample(birds);
+}
+
+void SepCMAESOptimiser::sample(std::vector<Bird> &birds)
+{
+    std::vector<float> genome(mean.size());
+    for (auto &bird : birds)
+    {
+        for (int j = 0; j < (int)mean.size(); ++j)
+        {
+            genome[j] = mean[j] + sigma * std::sqrt(variance[j]) * randomGaussian();
+        }
+        bird.setGenome(genome);
+        bird.reset();
+    }
+}
+
+void SepCMAESOptimiser::evolve(std::vector<Bird> &birds)
+{
+    const int lambda = (int)birds.size();
+    const int mu = std::max(lambda / 2, 1);
+    const float n = (float)mean.size();
+
+    std::vector<float> weights(mu);
+    float weightSum = 0.0f;
+    for (int i = 0; i < mu; ++i)
+    {
+        weights[i] = std::log(mu + 0.5f) - std::log(i + 1.0f);
+        weightSum += weights[i];
+    }
+    float weightSquares = 0.0f;
+    for (auto &weight : weights)
+    {
+        weight /= weightSum;
+        weightSquares += weight * weight;
+    }
+    const float muEff = 1.0f / weightSquares;
+
+    // Separable CMA-ES learning rates (Ros & Hansen 2008), rank one and rank mu scaled by (n + 2) / 3
+    const float cSigma = (muEff + 2.0f) / (n + muEff + 5.0f);
+    const float dSigma = 1.0f + 2.0f * std::max(0.0f, std::sqrt((muEff - 1.0f) / (n + 1.0f)) - 1.0f) + cSigma;
+    const float cC = (4.0f + muEff / n) / (n + 4.0f + 2.0f * muEff / n);
+    const float c1 = std::min(1.0f, 2.0f / ((n + 1.3f) * (n + 1.3f) + muEff) * (n + 2.0f) / 3.0f);
+    const float cMu = std::min(1.0f - c1, 2.0f * (muEff - 2.0f + 1.0f / muEff) / ((n + 2.0f) * (n + 2.0f) + muEff) * (n + 2.0f) / 3.0f);
+    const float expectedNorm = std::sqrt(n) * (1.0f - 1.0f / (4.0f * n) + 1.0f / (21.0f * n * n));
+
+    std::vector<int> order = rankByFitness(birds);
+
+    // Steps of the mu best samples in the coordinates of the current distribution
+    std::vector<std::vector<float>> steps(mu);
+    std::vector<float> weightedStep(mean.size(), 0.0f);
+    for (int i = 0; i < mu; ++i)
+    {
+        steps[i] = birds[order[i]].getGenome();
+        for (int j = 0; j < (int)mean.size(); ++j)
+        {
+            steps[i][j] = (steps[i][j] - mean[j]) / sigma;
+            weightedStep[j] += weights[i] * steps[i][j];
+        }
+    }
+
+    ++generation;
+    float pathSigmaNorm = 0.0f;
+    for (int j = 0; j < (int)mean.size(); ++j)
+    {
+        mean[j] += sigma * weightedStep[j];
+        pathSigma[j] = (1.0f - cSigma) * pathSigma[j] + std::sqrt(cSigma * (2.0f - cSigma) * muEff) * weightedStep[j] / std::sqrt(variance[j]);
+        pathSigmaNorm += pathSigma[j] * pathSigma[j];
+    }
+    pathSigmaNorm = std::sqrt(pathSigmaNorm);
+
+    bool stalled = pathSigmaNorm / std::sqrt(1.0f - std::pow(1.0f - cSigma, 2.0f * generation)) >= (1.4f + 2.0f / (n + 1.0f)) * expectedNorm;
+    float hSigma = stalled ? 0.0f : 1.0f;
+
+    for (int j = 0; j < (int)mean.size(); ++j)
+    {
+        pathC[j] = (1.0f - cC) * pathC[j] + hSigma * std::sqrt(cC * (2.0f - cC) * muEff) * weightedStep[j];
+
+        float rankMu = 0.0f;
+        for (int i = 0; i < mu; ++i)
+        {
+            rankMu += weights[i] * steps[i][j] * steps[i][j];
+        }
+        variance[j] = (1.0f - c1 - cMu) * variance[j] + c1 * (pathC[j] * pathC[j] + (1.0f - hSigma) * cC * (2.0f - cC) * variance[j]) + cMu * rankMu;
+    }
+
+    sigma *= std::exp((cSigma / dSigma) * (pathSigmaNorm / expectedNorm - 1.0f));
+
+    sample(birds);
+}
+
+const char *SepCMAESOptimiser::getName()
+{
+    return "sep-cma-es";
+}
+
+NeatOptimiser::NeatOptimiser(int inputs, int outputs) : inputs(inputs), outputs(outputs), innovations(inputs, outputs), compatibilityThreshold(3.0f), targetSpecies(8), nextSpeciesId(0)
+{
+}
+
+void NeatOptimiser::initialise(std::vector<Bird> &birds)
+{
+    for (auto &bird : birds)
+    {
+        bird.setNetwork(std::make_shared<NeatNetwork>(NeatGenome(inputs, outputs, innovations)));
+        bird.reset();
+    }
+}
+
+void NeatOptimiser::speciate(std::vector<NeatGenome> &genomes)
+{
+    for (auto &group : species)
+    {
+        group.members.clear();
+    }
+
+    for (int i = 0; i < (int)genomes.size(); ++i)
+    {
+        bool placed = false;
+        for (auto &group : species)
+        {
+            if (genomes[i].distance(group.representative) < compatibilityThreshold)
+            {
+                group.members.push_back(i);
+                placed = true;
+                break;
+            }
+        }
+        if (!placed)
+            species.push_back({nextSpeciesId++, genomes[i], {i}, 0, 0});
+    }
+
+    species.erase(std::remove_if(species.begin(), species.end(), [](Species &group)
+                                 { return group.members.empty(); }),
+                  species.end());
+    for (auto &group : species)
+    {
+        group.representative = genomes[group.members[randomInt((int)group.members.size())]];
+    }
+
+    // Steer the threshold towards the wanted number of species
+    if ((int)species.size() < targetSpecies)
+        compatibilityThreshold = std::max(0.5f, compatibilityThreshold - 0.3f);
+    else if ((int)species.size() > targetSpecies)
+        compatibilityThreshold += 0.3f;
+}
+
+void NeatOptimiser::evolve(std::vector<Bird> &birds)
+{
+    int count = (int)birds.size();
+
+    std::vector<NeatGenome> genomes;
+    std::vector<int> fitness;
+    genomes.reserve(count);
+    for (auto &bird : birds)
+    {
+        genomes.push_back(bird.getNetwork() ? bird.getNetwork()->getGenome() : NeatGenome(inputs, outputs, innovations));
+        fitness.push_back(std::max(bird.getFitness(), 0));
+    }
+
+    speciate(genomes);
+
+    int globalBest = (int)(std::max_element(fitness.begin(), fitness.end()) - fitness.begin());
+    for (auto &group : species)
+    {
+        std::sort(group.members.begin(), group.members.end(), [&fitness](int a, int b)
+                  { return fitness[a] > fitness[b]; });
+
+        if (fitness[group.members[0]] > group.bestFitness)
+        {
+            group.bestFitness = fitness[group.members[0]];
+            group.stagnation = 0;
+        }
+        else
+        {
+            ++group.stagnation;
+        }
+    }
+
+    // Stagnant species die out, but never the one holding the champion
+    species.erase(std::remove_if(species.begin(), species.end(), [globalBest](Species &group)
+                                 { return group.stagnation >= 15 && std::find(group.members.begin(), group.members.end(), globalBest) == group.members.end(); }),
+                  species.end());
+
+    // Explicit fitness sharing : a species earns offspring by the mean fitness of its members
+    std::vector<double> shared(species.size(), 0.0);
+    double totalShared = 0.0;
+    for (size_t s = 0; s < species.size(); ++s)
+    {
+        for (int member : species[s].members)
+        {
+            shared[s] += fitness[member];
+        }
+        shared[s] /= species[s].members.size();
+        totalShared += shared[s];
+    }
+
+    std::vector<int> offspring(species.size(), 0);
+    int assigned = 0;
+    for (size_t s = 0; s < species.size(); ++s)
+    {
+        offspring[s] = totalShared > 0.0 ? (int)(count * shared[s] / totalShared) : count / (int)species.size();
+        assigned += offspring[s];
+    }
+    int bestSpecies = (int)(std::max_element(shared.begin(), shared.end()) - shared.begin());
+    offspring[bestSpecies] += count - assigned;
+
+    std::vector<NeatGenome> nextGeneration;
+    nextGeneration.reserve(count);
+    for (size_t s = 0; s < species.size(); ++s)
+    {
+        std::vector<int> &members = species[s].members;
+        int parents = std::max(1, ((int)members.size() + 1) / 2);
+
+        for (int child = 0; child < offspring[s]; ++child)
+        {
+            if (child == 0 && members.size() >= 5)
+            {
+                nextGeneration.push_back(genomes[members[0]]); // Species champion survives untouched
+                continue;
+            }
+
+            int first = members[randomInt(parents)];
+            NeatGenome genome = genomes[first];
+            if (randomUniform() < 0.75f)
+            {
+                int second = members[randomInt(parents)];
+                genome = fitness[first] >= fitness[second] ? NeatGenome::crossover(genomes[first], genomes[second]) : NeatGenome::crossover(genomes[second], genomes[first]);
+            }
+            genome.mutate(innovations);
+            nextGeneration.push_back(genome);
+        }
+    }
+
+    int connectionTotal = 0;
+    for (int i = 0; i < count; ++i)
+    {
+        std::shared_ptr<const NeatNetwork> network = std::make_shared<NeatNetwork>(nextGeneration[i]);
+        connectionTotal += network->getConnectionCount();
+        birds[i].setNetwork(network);
+        birds[i].reset();
+    }
+
+    SDL_Log("NEAT : SPECIES : %i : THRESHOLD : %.2f : MEAN CONNECTIONS : %.1f (dense net : %i)", (int)species.size(), compatibilityThreshold, (float)connectionTotal / count, birds[0].getGenomeSize());
+}
+
+const char *NeatOptimiser::getName()
+{
+    return "neat";
+}
+
+bool NeatOptimiser::ownsEncoding()
+{
+    return true;
+}
+
+#define SPECIES_MINI_BATCH_THRESHOLD 4096
+#define SPECIES_MINI_BATCH 1024
+#define SPECIES_ITERATIONS 8
+
+static void runChunks(ThreadPool *pool, int chunkCount, const std::function<void(int, int)> &task);
+
+SpeciesOptimiser::SpeciesOptimiser(float mutationRate, int speciesCount) : mutationRate(mutationRate), speciesCount(std::max(speciesCount, 1)), pool(nullptr), dimensions(0)
+{
+}
+
+void SpeciesOptimiser::initialise(std::vector<Bird> &)
+{
+    centroids.clear();
+}
+
+void SpeciesOptimiser::assign(const std::vector<float> &genomes, const std::vector<int> &points, std::vector<int> &labels)
+{
+    int k = (int)centroids.size() / dimensions;
+    int count = (int)points.size();
+    int chunks = std::min(count, (pool ? pool->getThreadCount() : 1) * 4);
+    int chunkSize = (count + chunks - 1) / chunks;
+
+    runChunks(pool, chunks, [&](int chunk, int)
+              {
+        int end = std::min((chunk + 1) * chunkSize, count);
+        for (int i = chunk * chunkSize; i < end; ++i)
+        {
+            const float *genome = &genomes[(size_t)points[i] * dimensions];
+            int best = 0;
+            float bestDistance = squaredDistance(genome, &centroids[0], dimensions);
+            for (int c = 1; c < k; ++c)
+            {
+                float distance = squaredDistance(genome, &centroids[(size_t)c * dimensions], dimensions);
+                if (distance < bestDistance)
+                {
+                    bestDistance = distance;
+                    best = c;
+                }
+            }
+            labels[points[i]] = best;
+        } });
+}
+
+void SpeciesOptimiser::cluster(const std::vector<float> &genomes, int count, std::vector<int> &labels)
+{
+    int k = std::min(speciesCount, count);
+
+    // The previous generation's centroids are a warm start, otherwise k distinct birds seed them
+    if ((int)centroids.size() != k * dimensions)
+    {
+        std::vector<int> order(count);
+        for (int i = 0; i < count; ++i)
+        {
+            order[i] = i;
+        }
+        for (int c = 0; c < k; ++c)
+        {
+            std::swap(order[c], order[c + randomInt(count - c)]);
+        }
+
+        centroids.resize((size_t)k * dimensions);
+        for (int c = 0; c < k; ++c)
+        {
+            std::copy(&genomes[(size_t)order[c] * dimensions], &genomes[(size_t)order[c] * dimensions] + dimensions, &centroids[(size_t)c * dimensions]);
+        }
+    }
+
+    std::vector<int> everyone(count);
+    for (int i = 0; i < count; ++i)
+    {
+        everyone[i] = i;
+    }
+
+    if (count > SPECIES_MINI_BATCH_THRESHOLD)
+    {
+        // Mini-batch k-means : each centroid moves towards its batch points with a step of 1 / points seen
+        std::vector<int> seen(k, 0);
+        std::vector<int> batch(SPECIES_MINI_BATCH);
+        for (int iteration = 0; iteration < SPECIES_ITERATIONS; ++iteration)
+        {
+            for (auto &point : batch)
+            {
+                point = randomInt(count);
+            }
+            assign(genomes, batch, labels);
+
+            for (int point : batch)
+            {
+                int c = labels[point];
+                float step = 1.0f / ++seen[c];
+                float *centroid = &centroids[(size_t)c * dimensions];
+                const float *genome = &genomes[(size_t)point * dimensions];
+                for (int d = 0; d < dimensions; ++d)
+                {
+                    centroid[d] += step * (genome[d] - centroid[d]);
+                }
+            }
+        }
+
+        assign(genomes, everyone, labels);
+        return;
+    }
+
+    std::vector<int> previous;
+    for (int iteration = 0; iteration < SPECIES_ITERATIONS; ++iteration)
+    {
+        assign(genomes, everyone, labels);
+        if (labels == previous)
+            break;
+        previous = labels;
+
+        // Sums run in index order, so the centroids do not depend on thread scheduling
+        std::vector<double> sums((size_t)k * dimensions, 0.0);
+        std::vector<int> sizes(k, 0);
+        for (int i = 0; i < count; ++i)
+        {
+            const float *genome = &genomes[(size_t)i * dimensions];
+            double *sum = &sums[(size_t)labels[i] * dimensions];
+            for (int d = 0; d < dimensions; ++d)
+            {
+                sum[d] += genome[d];
+            }
+            ++sizes[labels[i]];
+        }
+
+        for (int c = 0; c < k; ++c)
+        {
+            // An empty species keeps its centroid and may pick up members later
+            if (sizes[c] == 0)
+                continue;
+            for (int d = 0; d < dimensions; ++d)
+            {
+                centroids[(size_t)c * dimensions + d] = (float)(sums[(size_t)c * dimensions + d] / sizes[c]);
+            }
+        }
+    }
+}
+
+void SpeciesOptimiser::evolve(std::vector<Bird> &birds)
+{
+    Uint64 start = SDL_GetTicks();
+    int count = (int)birds.size();
+
+    dimensions = birds[0].getGenomeSize();
+    std::vector<float> genomes((size_t)count * dimensions);
+    runChunks(pool, count, [&](int i, int)
+              {
+        std::vector<float> genome = birds[i].getGenome();
+        std::copy(genome.begin(), genome.end(), &genomes[(size_t)i * dimensions]); });
+
+    labels.assign(count, 0);
+    cluster(genomes, count, labels);
+    int clusteringTime = (int)(SDL_GetTicks() - start);
+
+    int alive = 0;
+    int largest = 0;
+    breed(birds, alive, largest);
+    SDL_Log("Species : SPECIES : %i : LARGEST : %i : CLUSTERING TIME : %i ms", alive, largest, clusteringTime);
+}
+
+void SpeciesOptimiser::proposeOffspring(std::vector<Bird> &birds)
+{
+    // Clustering again would move the centroids, the species of the last evolve still hold for the same birds
+    if (labels.size() != birds.size())
+    {
+        evolve(birds);
+        return;
+    }
+
+    int alive = 0;
+    int largest = 0;
+    breed(birds, alive, largest);
+}
+
+void SpeciesOptimiser::breed(std::vector<Bird> &birds, int &alive, int &largest)
+{
+    int count = (int)birds.size();
+    int k = (int)centroids.size() / dimensions;
+
+    std::vector<std::vector<int>> members(k);
+    for (int i = 0; i < count; ++i)
+    {
+        members[labels[i]].push_back(i);
+    }
+
+    // Fitness sharing : a species earns offspring by its mean fitness, not by its head count
+    std::vector<double> share(k, 0.0);
+    double totalShare = 0.0;
+    for (int c = 0; c < k; ++c)
+    {
+        if (members[c].empty())
+            continue;
+        for (int i : members[c])
+        {
+            share[c] += birds[i].getFitness();
+        }
+        share[c] /= members[c].size();
+        totalShare += share[c];
+    }
+
+    std::vector<int> quota(k, 0);
+    std::vector<std::pair<double, int>> remainders;
+    int assigned = 0;
+    for (int c = 0; c < k; ++c)
+    {
+        if (members[c].empty())
+            continue;
+        double exact = totalShare > 0.0 ? count * share[c] / totalShare : (double)members[c].size();
+        quota[c] = (int)exact;
+        assigned += quota[c];
+        remainders.push_back({exact - quota[c], c});
+    }
+    std::sort(remainders.begin(), remainders.end(), [](const std::pair<double, int> &a, const std::pair<double, int> &b)
+              { return a.first > b.first || (a.first == b.first && a.second < b.second); });
+    for (int r = 0; assigned < count; r = (r + 1) % (int)remainders.size(), ++assigned)
+    {
+        ++quota[remainders[r].second];
+    }
+
+    std::vector<Bird> newGeneration;
+    newGeneration.reserve(count);
+
+    for (int c = 0; c < k; ++c)
+    {
+        if (quota[c] == 0)
+            continue;
+        largest = std::max(largest, (int)members[c].size());
+
+        // The species champion survives unchanged, the rest are tournament winners of the species mutated
+        int champion = members[c][0];
+        for (int i : members[c])
+        {
+            if (birds[i].getFitness() > birds[champion].getFitness())
+                champion = i;
+        }
+
+        Bird elite = birds[champion];
+        elite.reset();
+        newGeneration.push_back(elite);
+
+        for (int n = 1; n < quota[c]; ++n)
+        {
+            int a = members[c][randomInt((int)members[c].size())];
+            int b = members[c][randomInt((int)members[c].size())];
+            Bird child = birds[birds[a].getFitness() >= birds[b].getFitness() ? a : b];
+            child.reset();
+            child.mutate(mutationRate);
+            newGeneration.push_back(child);
+        }
+    }
+
+    for (int c = 0; c < k; ++c)
+    {
+        alive += quota[c] > 0;
+    }
+
+    birds = newGeneration;
+}
+
+const char *SpeciesOptimiser::getName()
+{
+    return "species";
+}
+
+void SpeciesOptimiser::setThreadPool(ThreadPool *pool)
+{
+    this->pool = pool;
+}
+
+std::unique_ptr<Optimiser> createOptimiser(const TrainingConfig &config)
+{
+    if (config.optimiser == "openai-es")
+        return std::make_unique<OpenAIESOptimiser>(config.sigma, config.learningRate);
+    if (config.optimiser == "sep-cma-es")
+        return std::make_unique<SepCMAESOptimiser>(config.sigma);
+    if (config.optimiser == "neat")
+        return std::make_unique<NeatOptimiser>(RAYS_NUMBER, 1);
+    if (config.optimiser == "species")
+        return std::make_unique<SpeciesOptimiser>(config.mutationRate, config.species);
+    if (config.optimiser != "elitist")
+        SDL_Log("Unknown optimiser %s, using elitist", config.optimiser.c_str());
+    return std::make_unique<ElitistOptimiser>(config.mutationRate);
+}
+
+// ----- Optimiser Class Decleration End -----
+
+// ----- NoveltySearch Class Decleration Start -----
+
+KdTree::KdTree(int dimensions) : dimensions(dimensions), root(-1), balancedSize(0)
+{
+}
+
+int KdTree::build(std::vector<int> &order, int begin, int end, int depth)
+{
+    if (begin >= end)
+        return -1;
+
+    int axis = depth % dimensions;
+    int middle = (begin + end) / 2;
+    std::nth_element(order.begin() + begin, order.begin() + middle, order.begin() + end, [this, axis](int a, int b)
+                     { return points[a * dimensions + axis] < points[b * dimensions + axis]; });
+
+    int node = order[middle];
+    nodes[node].axis = axis;
+    nodes[node].left = build(order, begin, middle, depth + 1);
+    nodes[node].right = build(order, middle + 1, end, depth + 1);
+    return node;
+}
+
+void KdTree::rebuild()
+{
+    std::vector<int> order(nodes.size());
+    for (int i = 0; i < (int)order.size(); ++i)
+    {
+        order[i] = i;
+    }
+    root = build(order, 0, (int)order.size(), 0);
+    balancedSize = (int)nodes.size();
+}
+
+void KdTree::insert(const std::vector<float> &point)
+{
+    int index = (int)nodes.size();
+    points.insert(points.end(), point.begin(), point.end());
+    nodes.push_back({index, 0, -1, -1});
+
+    // Rebalancing every time the tree doubles keeps inserts and queries logarithmic (amortised)
+    if (index + 1 >= 2 * balancedSize)
+    {
+        rebuild();
+        return;
+    }
+
+    int parent = root;
+    int depth = 0;
+    while (true)
+    {
+        Node &current = nodes[parent];
+        int &child = point[current.axis] < points[parent * dimensions + current.axis] ? current.left : current.right;
+        if (child < 0)
+        {
+            child = index;
+            break;
+        }
+        parent = child;
+        ++depth;
+    }
+    nodes[index].axis = (depth + 1) % dimensions;
+}
+
+void KdTree::search(int node, const float *query, int k, std::vector<std::pair<float, int>> &best)
+{
+    if (node < 0)
+        return;
+
+    const float *point = &points[node * dimensions];
+    float distance = 0.0f;
+    for (int d = 0; d < dimensions; ++d)
+    {
+        float difference = point[d] - query[d];
+        distance += difference * difference;
+    }
+
+    // best is a max-heap of squared distances
+    if ((int)best.size() < k)
+    {
+        best.push_back({distance, node});
+        std::push_heap(best.begin(), best.end());
+    }
+    else if (distance < best.front().first)
+    {
+        std::pop_heap(best.begin(), best.end());
+        best.back() = {distance, node};
+        std::push_heap(best.begin(), best.end());
+    }
+
+    int axis = nodes[node].axis;
+    float offset = query[axis] - point[axis];
+    int nearSide = offset < 0 ? nodes[node].left : nodes[node].right;
+    int farSide = offset < 0 ? nodes[node].right : nodes[node].left;
+
+    search(nearSide, query, k, best);
+    if ((int)best.size() < k || offset * offset < best.front().first)
+        search(farSide, query, k, best);
+}
+
+std::vector<float> KdTree::nearestDistances(const std::vector<float> &query, int k)
+{
+    std::vector<std::pair<float, int>> best;
+    best.reserve(k + 1);
+    search(root, query.data(), k, best);
+
+    std::sort_heap(best.begin(), best.end());
+    std::vector<float> distances(best.size());
+    for (size_t i = 0; i < best.size(); ++i)
+    {
+        distances[i] = std::sqrt(best[i].first);
+    }
+    return distances;
+}
+
+int KdTree::getSize()
+{
+    return (int)nodes.size();
+}
+
+NoveltySearch::NoveltySearch(int neighbours, float archiveRate) : archive(BEHAVIOUR_SAMPLES), neighbours(neighbours), archiveRate(archiveRate)
+{
+}
+
+void NoveltySearch::score(std::vector<Bird> &birds)
+{
+    Uint64 start = SDL_GetTicks();
+
+    std::vector<std::vector<float>> behaviours;
+    behaviours.reserve(birds.size());
+    KdTree generation(BEHAVIOUR_SAMPLES);
+    for (auto &bird : birds)
+    {
+        behaviours.push_back(bird.getBehaviour());
+        generation.insert(behaviours.back());
+    }
+
+    double totalNovelty = 0.0;
+    for (size_t i = 0; i < birds.size(); ++i)
+    {
+        // Nearest neighbours come from the archive and from this generation, minus the bird itself
+        std::vector<float> distances = archive.nearestDistances(behaviours[i], neighbours);
+        std::vector<float> siblings = generation.nearestDistances(behaviours[i], neighbours + 1);
+        if (!siblings.empty())
+            siblings.erase(siblings.begin());
+
+        distances.insert(distances.end(), siblings.begin(), siblings.end());
+        int k = std::min(neighbours, (int)distances.size());
+        std::partial_sort(distances.begin(), distances.begin() + k, distances.end());
+
+        float novelty = 0.0f;
+        for (int n = 0; n < k; ++n)
+        {
+            novelty += distances[n];
+        }
+        novelty = k ? novelty / k : 0.0f;
+        totalNovelty += novelty;
+
+        birds[i].setFitness((int)(novelty * 1000.0f));
+    }
+
+    for (auto &behaviour : behaviours)
+    {
+        if (randomUniform() < archiveRate)
+            archive.insert(behaviour);
+    }
+
+    SDL_Log("Novelty : ARCHIVE : %i : MEAN NOVELTY : %.3f : SCORING TIME : %i ms", archive.getSize(), totalNovelty / std::max<size_t>(birds.size(), 1), (int)(SDL_GetTicks() - start));
+}
+
+int NoveltySearch::getArchiveSize()
+{
+    return archive.getSize();
+}
+
+// ----- NoveltySearch Class Decleration End -----
+
+// ----- SurrogateModel Class Decleration Start -----
+
+#define SURROGATE_MAX_SAMPLES 2048
+
+SurrogateModel::SurrogateModel(int genomeSize, double ridge, double forgetting) : dimensions(genomeSize + 1), ridge(ridge), forgetting(forgetting), samples(0)
+{
+    gram.assign((size_t)dimensions * dimensions, 0.0);
+    moments.assign(dimensions, 0.0);
+    weights.assign(dimensions, 0.0f);
+}
+
+void SurrogateModel::train(std::vector<Bird> &birds)
+{
+    for (auto &value : gram)
+        value *= forgetting;
+    for (auto &value : moments)
+        value *= forgetting;
+
+    // Rank-one updates cost dimensions^2 each, so large generations are subsampled
+    int count = (int)birds.size();
+    int used = std::min(count, SURROGATE_MAX_SAMPLES);
+    std::vector<double> x(dimensions);
+    for (int n = 0; n < used; ++n)
+    {
+        Bird &bird = birds[used == count ? n : randomInt(count)];
+        std::vector<float> genome = bird.getGenome();
+        std::copy(genome.begin(), genome.end(), x.begin());
+        x[dimensions - 1] = 1.0;
+
+        double y = bird.getFitness();
+        for (int i = 0; i < dimensions; ++i)
+        {
+            double *row = &gram[(size_t)i * dimensions];
+            for (int j = i; j < dimensions; ++j)
+            {
+                row[j] += x[i] * x[j];
+            }
+            moments[i] += y * x[i];
+        }
+    }
+    samples += used;
+
+    // Solve (X^T X + ridge I) w = X^T y with a Cholesky factorisation of the upper triangle
+    std::vector<double> factor((size_t)dimensions * dimensions, 0.0);
+    for (int i = 0; i < dimensions; ++i)
+    {
+        for (int j = 0; j <= i; ++j)
+        {
+            double sum = gram[(size_t)j * dimensions + i] + (i == j ? ridge : 0.0);
+            for (int k = 0; k < j; ++k)
+            {
+                sum -= factor[(size_t)i * dimensions + k] * factor[(size_t)j * dimensions + k];
+            }
+            factor[(size_t)i * dimensions + j] = i == j ? std::sqrt(std::max(sum, 1e-12)) : sum / factor[(size_t)j * dimensions + j];
+        }
+    }
+
+    std::vector<double> solution(moments);
+    for (int i = 0; i < dimensions; ++i)
+    {
+        for (int k = 0; k < i; ++k)
+        {
+            solution[i] -= factor[(size_t)i * dimensions + k] * solution[k];
+        }
+        solution[i] /= factor[(size_t)i * dimensions + i];
+    }
+    for (int i = dimensions - 1; i >= 0; --i)
+    {
+        for (int k = i + 1; k < dimensions; ++k)
+        {
+            solution[i] -= factor[(size_t)k * dimensions + i] * solution[k];
+        }
+        solution[i] /= factor[(size_t)i * dimensions + i];
+    }
+
+    for (int i = 0; i < dimensions; ++i)
+    {
+        weights[i] = (float)solution[i];
+    }
+}
+
+float SurrogateModel::predict(Bird &bird)
+{
+    std::vector<float> genome = bird.getGenome();
+    float score = weights[dimensions - 1];
+    for (int i = 0; i < dimensions - 1; ++i)
+    {
+        score += weights[i] * genome[i];
+    }
+    return score;
+}
+
+bool SurrogateModel::isReady()
+{
+    // Fewer samples than features and the fit is mostly the ridge prior
+    return samples >= dimensions;
+}
+
+// Spearman correlation, tied values share their average rank
+static float rankCorrelation(const std::vector<float> &a, const std::vector<float> &b)
+{
+    auto ranks = [](const std::vector<float> &values)
+    {
+        std::vector<int> order(values.size());
+        for (int i = 0; i < (int)order.size(); ++i)
+        {
+            order[i] = i;
+        }
+        std::sort(order.begin(), order.end(), [&values](int x, int y)
+                  { return values[x] < values[y]; });
+
+        std::vector<double> rank(values.size());
+        for (int i = 0; i < (int)order.size();)
+        {
+            int j = i;
+            while (j + 1 < (int)order.size() && values[order[j + 1]] == values[order[i]])
+            {
+                ++j;
+            }
+            for (int k = i; k <= j; ++k)
+            {
+                rank[order[k]] = (i + j) / 2.0;
+            }
+            i = j + 1;
+        }
+        return rank;
+    };
+
+    std::vector<double> ra = ranks(a);
+    std::vector<double> rb = ranks(b);
+    int n = (int)a.size();
+    double meanA = 0.0, meanB = 0.0;
+    for (int i = 0; i < n; ++i)
+    {
+        meanA += ra[i];
+        meanB += rb[i];
+    }
+    meanA /= n;
+    meanB /= n;
+
+    double covariance = 0.0, varianceA = 0.0, varianceB = 0.0;
+    for (int i = 0; i < n; ++i)
+    {
+        covariance += (ra[i] - meanA) * (rb[i] - meanB);
+        varianceA += (ra[i] - meanA) * (ra[i] - meanA);
+        varianceB += (rb[i] - meanB) * (rb[i] - meanB);
+    }
+    if (varianceA <= 0.0 || varianceB <= 0.0)
+        return 0.0f;
+    return (float)(covariance / std::sqrt(varianceA * varianceB));
+}
+
+// ----- SurrogateModel Class Decleration End -----
+
+// ----- Population Class Decleration Start -----
+
+Population::Population(int size, float mRate, int archiveSize) : archive(archiveSize), births(0), optimiser(new ElitistOptimiser(mRate)), cacheEnabled(false), cacheHits(0), cacheLookups(0), arenas{new GenomeArena(), new GenomeArena()}, currentArena(0), diversityEnabled(false)
+{
+    generationNumber = 1;
+    mutationRate = mRate;
+    populationSize = size;
+
+    for (int i = 0; i < populationSize; ++i)
+    {
+        // population.push_back(Bird(10, {12, 12}, 1));
+        population.push_back(Bird(10, {11, 11}, 1));
+    }
+    states.reset(populationSize);
+}
+
+Population::Population(const TrainingConfig &config) : Population(config.populationSize, config.mutationRate, config.archiveSize)
+{
+    optimiser = createOptimiser(config);
+    optimiser->initialise(population);
+
+    // Children inherit the flag, so only mutations of the founders' lineage are stored as deltas
+    for (auto &bird : population)
+    {
+        bird.setDeltaEncoded(config.deltaGenomes);
+    }
+
+    if (config.novelty)
+        novelty = std::make_unique<NoveltySearch>(config.noveltyNeighbours, config.noveltyArchiveRate);
+
+    // NEAT birds fly their network, so their flat genomes say nothing about the population
+    diversityEnabled = config.diversity && config.optimiser != "neat";
+
+    // Only optimisers whose offspring are independent mutations can be asked for more of them
+    surrogateFraction = config.surrogateFraction;
+    if (surrogateFraction > 0.0f && surrogateFraction < 1.0f)
+    {
+        if (config.optimiser == "elitist" || config.optimiser == "species")
+            surrogate = std::make_unique<SurrogateModel>(population[0].getGenomeSize(), 1.0, 0.8);
+        else
+            SDL_Log("Surrogate prefiltering needs the elitist or species optimiser, disabling it");
+    }
+
+    cacheEnabled = config.fitnessCache;
+    if (cacheEnabled && (config.novelty || config.optimiser != "elitist"))
+    {
+        // Skipped birds record no behaviour, and the other optimisers tie fitness to the slot they sampled
+        SDL_Log("Fitness cache needs the elitist optimiser without novelty search, disabling it");
+        cacheEnabled = false;
+    }
+}
+
+Population::~Population()
+{
+    // Blocks still held elsewhere, by migrants for instance, keep their arena alive
+    population.clear();
+    cachedBirds.clear();
+    arenas[0]->release();
+    arenas[1]->release();
+}
+
+void Population::evolveNewGeneration()
+{
+    if (diversityEnabled)
+        logDiversity();
+
+    if (novelty)
+        novelty->score(population);
+
+    // The spare arena is rewound in one step, unless blocks of two generations ago still live
+    int next = 1 - currentArena;
+    if (arenas[next]->isIdle())
+    {
+        arenas[next]->reset();
+    }
+    else
+    {
+        arenas[next]->release();
+        arenas[next] = new GenomeArena();
+    }
+
+    GenomeArena *previous = GenomeArena::use(arenas[next]);
+    if (surrogate)
+        evolveWithSurrogate();
+    else
+        optimiser->evolve(population);
+    ++generationNumber;
+
+    // Cache hits rejoined the generation for selection, drop the extra offspring.
+    // Every episode flies exactly populationSize birds, which is what the island and game environments were sized for
+    if ((int)population.size() > populationSize)
+        population.erase(population.begin() + populationSize, population.end());
+
+    // Elites and unmutated blocks still point into the old arena, copy them over so it drains
+    std::unordered_map<GenomeBlock *, GenomeBlock *> moved;
+    for (auto &bird : population)
+    {
+        bird.relocateGenome(arenas[next], moved);
+    }
+    GenomeArena::use(previous);
+
+    currentArena = next;
+}
+
+void Population::evolveWithSurrogate()
+{
+    int scoredCount = (int)population.size();
+
+    // How well last generation's predictions ranked the birds that were then simulated
+    float correlation = 0.0f;
+    bool measured = (int)predictions.size() == scoredCount && scoredCount > 1;
+    if (measured)
+    {
+        std::vector<float> fitness(scoredCount);
+        for (int i = 0; i < scoredCount; ++i)
+        {
+            fitness[i] = (float)population[i].getFitness();
+        }
+        correlation = rankCorrelation(predictions, fitness);
+    }
+
+    surrogate->train(population);
+
+    std::vector<Bird> scored = population;
+    optimiser->evolve(population);
+    predictions.clear();
+
+    if (!surrogate->isReady())
+    {
+        SDL_Log("Surrogate : GENERATION : %i : WARMING UP", generationNumber);
+        return;
+    }
+
+    // Parents carried over unmutated are already known, they always go through
+    std::unordered_map<Uint64, int> parents;
+    for (auto &bird : scored)
+    {
+        parents[bird.getGenomeHash()] = 1;
+    }
+
+    std::vector<Bird> candidates = population;
+    int rounds = (int)std::ceil(1.0f / surrogateFraction);
+    for (int round = 1; round < rounds; ++round)
+    {
+        std::vector<Bird> offspring = scored;
+        optimiser->proposeOffspring(offspring);
+        candidates.insert(candidates.end(), offspring.begin(), offspring.end());
+    }
+
+    std::vector<float> scores(candidates.size());
+    std::vector<int> order;
+    std::vector<int> kept;
+    for (int i = 0; i < (int)candidates.size(); ++i)
+    {
+        scores[i] = surrogate->predict(candidates[i]);
+
+        auto parent = parents.find(candidates[i].getGenomeHash());
+        if (parent != parents.end())
+        {
+            // Only the first copy of a parent is kept, the duplicates would fly the same episode
+            if (parent->second)
+                kept.push_back(i);
+            parent->second = 0;
+            continue;
+        }
+        order.push_back(i);
+    }
+
+    int target = std::min((int)population.size(), populationSize);
+    std::stable_sort(order.begin(), order.end(), [&scores](int a, int b)
+                     { return scores[a] > scores[b]; });
+    for (int i = 0; (int)kept.size() < target && i < (int)order.size(); ++i)
+    {
+        kept.push_back(order[i]);
+    }
+    kept.resize(std::min((int)kept.size(), target));
+
+    population.clear();
+    for (int i : kept)
+    {
+        population.push_back(candidates[i]);
+        predictions.push_back(scores[i]);
+    }
+
+    if (measured)
+        SDL_Log("Surrogate : GENERATION : %i : SIMULATED / GENERATED : %i / %i (%.0f%%) : RANK CORRELATION : %.3f",
+                generationNumber, (int)population.size(), (int)candidates.size(), 100.0f * population.size() / candidates.size(), correlation);
+    else
+        SDL_Log("Surrogate : GENERATION : %i : SIMULATED / GENERATED : %i / %i (%.0f%%)",
+                generationNumber, (int)population.size(), (int)candidates.size(), 100.0f * population.size() / candidates.size());
+}
+
+#define DIVERSITY_PAIRS 4096
+
+void Population::logDiversity()
+{
+    int count = (int)population.size();
+    int dimensions = population[0].getGenomeSize();
+
+    std::vector<float> genomes((size_t)count * dimensions);
+    for (int i = 0; i < count; ++i)
+    {
+        std::vector<float> genome = population[i].getGenome();
+        std::copy(genome.begin(), genome.end(), &genomes[(size_t)i * dimensions]);
+    }
+
+    std::vector<float> centroid(dimensions, 0.0f);
+    for (int i = 0; i < count; ++i)
+    {
+        accumulate(centroid.data(), &genomes[(size_t)i * dimensions], dimensions);
+    }
+    for (auto &value : centroid)
+    {
+        value /= count;
+    }
+
+    std::vector<float> variance(dimensions, 0.0f);
+    double centroidDistance = 0.0;
+    for (int i = 0; i < count; ++i)
+    {
+        const float *genome = &genomes[(size_t)i * dimensions];
+        accumulateSquaredDeviation(variance.data(), genome, centroid.data(), dimensions);
+        centroidDistance += std::sqrt(squaredDistance(genome, centroid.data(), dimensions));
+    }
+
+    // Every pair while there are few enough, a fixed number of random pairs beyond that
+    double pairwiseDistance = 0.0;
+    long long pairs = (long long)count * (count - 1) / 2;
+    if (pairs <= DIVERSITY_PAIRS)
+    {
+        for (int i = 0; i < count; ++i)
+            for (int j = i + 1; j < count; ++j)
+                pairwiseDistance += std::sqrt(squaredDistance(&genomes[(size_t)i * dimensions], &genomes[(size_t)j * dimensions], dimensions));
+    }
+    else
+    {
+        pairs = DIVERSITY_PAIRS;
+        for (int p = 0; p < DIVERSITY_PAIRS; ++p)
+        {
+            int i = randomInt(count);
+            int j = (i + 1 + randomInt(count - 1)) % count;
+            pairwiseDistance += std::sqrt(squaredDistance(&genomes[(size_t)i * dimensions], &genomes[(size_t)j * dimensions], dimensions));
+        }
+    }
+
+    // Per-parameter variance across the population, averaged over each weight layer
+    std::string layers;
+    int offset = 0;
+    for (int size : population[0].getWeightLayerSizes())
+    {
+        double total = 0.0;
+        for (int d = offset; d < offset + size; ++d)
+        {
+            total += variance[d] / count;
+        }
+        offset += size;
+
+        char text[32];
+        SDL_snprintf(text, sizeof(text), layers.empty() ? "%.4f" : " / %.4f", total / size);
+        layers += text;
+    }
+
+    SDL_Log("Diversity : GENERATION : %i : MEAN PAIRWISE DISTANCE : %.3f : MEAN DISTANCE TO CENTROID : %.3f : LAYER WEIGHT VARIANCE : %s",
+            generationNumber, pairwiseDistance / std::max(pairs, 1LL), centroidDistance / count, layers.c_str());
+}
+
+Uint64 Population::cacheKey(Uint64 genomeHash, unsigned int seed)
+{
+    Uint64 key = genomeHash ^ (seed * 0x9E3779B97F4A7C15ull);
+    key ^= key >> 31;
+    key *= 0xBF58476D1CE4E5B9ull;
+    return key ^ (key >> 29);
+}
+
+int Population::applyFitnessCache(unsigned int seed)
+{
+    cacheHits = 0;
+    cacheLookups = 0;
+    if (!cacheEnabled)
+        return 0;
+
+    // Replacement offspring belong to this generation's arena
+    GenomeArena *previous = GenomeArena::use(arenas[currentArena]);
+
+    for (auto &bird : population)
+    {
+        // A known genome is scored now and its slot goes to a fresh offspring of it
+        for (int attempt = 0; attempt < 4; ++attempt)
+        {
+            ++cacheLookups;
+            auto found = fitnessCache.find(cacheKey(bird.getGenomeHash(), seed));
+            if (found == fitnessCache.end())
+                break;
+
+            ++cacheHits;
+            cachedBirds.push_back(bird);
+            cachedBirds.back().setFitness(found->second);
+
+            bird.reset();
+            bird.mutate(mutationRate);
+        }
+    }
+
+    GenomeArena::use(previous);
+    return cacheHits;
+}
+
+void Population::storeFitness(unsigned int seed)
+{
+    if (!cacheEnabled)
+        return;
+
+    if (fitnessCache.size() > (1u << 20))
+        fitnessCache.clear();
+
+    for (auto &bird : population)
+    {
+        fitnessCache[cacheKey(bird.getGenomeHash(), seed)] = bird.getFitness();
+    }
+
+    population.insert(population.end(), cachedBirds.begin(), cachedBirds.end());
+    cachedBirds.clear();
+}
+
+float Population::getCacheHitRate()
+{
+    return (float)cacheHits / std::max(cacheLookups, 1);
+}
+
+void Population::immigrate(const Bird &migrant)
+{
+    // The migrant keeps its fitness so it competes in the next selection
+    int worst = 0;
+    for (int i = 1; i < (int)population.size(); ++i)
+    {
+        if (population[i].getFitness() < population[worst].getFitness())
+        {
+            worst = i;
+        }
+    }
+    population[worst] = migrant;
+}
+
+Bird &Population::getBestBird()
+{
+    int best = 0;
+    for (int i = 1; i < (int)population.size(); ++i)
+    {
+        if (population[i].getFitness() > population[best].getFitness())
+        {
+            best = i;
+        }
+    }
+    return population[best];
+}
+
+int Population::refillDeadBirds()
+{
+    // Nothing stopped since the last refill
+    if (states.size() == (int)population.size() && states.aliveCount == states.size())
+        return 0;
+
+    int refilled = 0;
+    for (int slot = 0; slot < (int)population.size(); ++slot)
+    {
+        Bird &bird = population[slot];
+        if (!bird.getGameOver())
+            continue;
+
+        archive.offer(bird);
+
+        Bird child = archive.select();
+        child.reset();
+        // parseArguments refuses steady state for NEAT, whose networks only change at a generation barrier
+        if (!optimiser->ownsEncoding())
+            child.mutate(mutationRate);
+        bird = child;
+        if (slot < states.size())
+            states.resetSlot(slot);
+        ++refilled;
+    }
+
+    births += refilled;
+    return refilled;
+}
+
+std::vector<Bird> &Population::getPopulation()
+{
+    return population;
+}
+
+BirdStates &Population::getStates()
+{
+    return states;
+}
+
+int Population::getGenerationNumber()
+{
+    return generationNumber;
+}
+
+EliteArchive &Population::getArchive()
+{
+    return archive;
+}
+
+int Population::getBirths()
+{
+    return births;
+}
+
+Optimiser &Population::getOptimiser()
+{
+    return *optimiser;
+}
+
+int Population::getEliteThreshold()
+{
+    // Only the archive breeds in steady state, so a bird that cannot enter it is wasted simulation
+    return archive.getEntryFitness();
+}
+
+// ----- Population Class Decleration End -----
+
+// ----- Termination Class Decleration Start -----
+
+TerminationStats::TerminationStats()
+{
+    mutex = SDL_CreateMutex();
+}
+
+TerminationStats::~TerminationStats()
+{
+    SDL_DestroyMutex(mutex);
+}
+
+void TerminationStats::record(const char *policy, int birds, double secondsSaved)
+{
+    SDL_LockMutex(mutex);
+    auto &entry = stops[policy];
+    entry.first += birds;
+    entry.second += secondsSaved;
+    SDL_UnlockMutex(mutex);
+}
+
+void TerminationStats::log(const char *owner)
+{
+    SDL_LockMutex(mutex);
+    for (auto &entry : stops)
+    {
+        SDL_Log("%s : TERMINATION : %s : BIRDS STOPPED : %i : EST. SIM SECONDS SAVED : %.1f", owner, entry.first.c_str(), entry.second.first, entry.second.second);
+    }
+    SDL_UnlockMutex(mutex);
+}
+
+TerminationPolicy::TerminationPolicy(int horizonFrames) : horizonFrames(horizonFrames)
+{
+}
+
+void TerminationPolicy::reset()
+{
+}
+
+void TerminationPolicy::prepare(int)
+{
+}
+
+double TerminationPolicy::getSecondsSaved(const BirdStates &states, int index, float deltaTime)
+{
+    if (horizonFrames <= 0)
+        return 0.0;
+    return std::max(horizonFrames - states.framesAlive[index], 0) * (double)deltaTime;
+}
+
+EpisodeLengthPolicy::EpisodeLengthPolicy(int maxFrames) : TerminationPolicy(maxFrames)
+{
+}
+
+const char *EpisodeLengthPolicy::getName()
+{
+    return "episode length";
+}
+
+bool EpisodeLengthPolicy::shouldStop(const BirdStates &states, int index, float)
+{
+    return states.framesAlive[index] >= horizonFrames;
+}
+
+NoProgressPolicy::NoProgressPolicy(int horizonFrames, float maxSeconds) : TerminationPolicy(horizonFrames), maxSeconds(maxSeconds)
+{
+}
+
+const char *NoProgressPolicy::getName()
+{
+    return "no progress";
+}
+
+void NoProgressPolicy::reset()
+{
+    lastScore.clear();
+    progressFrame.clear();
+}
+
+void NoProgressPolicy::prepare(int slots)
+{
+    if (slots > (int)lastScore.size())
+    {
+        lastScore.resize(slots, 0);
+        progressFrame.resize(slots, 0);
+    }
+}
+
+bool NoProgressPolicy::shouldStop(const BirdStates &states, int index, float deltaTime)
+{
+    if (index >= (int)lastScore.size())
+    {
+        lastScore.resize(index + 1, 0);
+        progressFrame.resize(index + 1, 0);
+    }
+
+    // A younger bird than the one tracked means the slot was refilled
+    int score = states.score[index];
+    int frames = states.framesAlive[index];
+    if (score != lastScore[index] || frames < progressFrame[index])
+    {
+        lastScore[index] = score;
+        progressFrame[index] = frames;
+        return false;
+    }
+
+    return (frames - progressFrame[index]) * deltaTime > maxSeconds;
+}
+
+DominancePolicy::DominancePolicy(int horizonFrames) : TerminationPolicy(horizonFrames), eliteThreshold(0)
+{
+}
+
+const char *DominancePolicy::getName()
+{
+    return "dominance";
+}
+
+bool DominancePolicy::shouldStop(const BirdStates &states, int index, float deltaTime)
+{
+    // Without a frame cap there is no bound on what a bird can still earn
+    if (eliteThreshold <= 0 || horizonFrames <= 0)
+        return false;
+
+    int remainingFrames = std::max(horizonFrames - states.framesAlive[index], 0);
+    return states.fitness[index] + Simulation::getFitnessGainBound(remainingFrames, deltaTime) < eliteThreshold;
+}
+
+void DominancePolicy::setEliteThreshold(int threshold)
+{
+    eliteThreshold = threshold;
+}
+
+// ----- Termination Class Decleration End -----
+
+// ----- FlappyEnv Class Decleration Start -----
+
+static void runChunks(ThreadPool *pool, int chunkCount, const std::function<void(int, int)> &task)
+{
+    if (pool)
+    {
+        pool->parallelFor(chunkCount, task);
+        return;
+    }
+
+    for (int chunk = 0; chunk < chunkCount; ++chunk)
+    {
+        task(chunk, 0);
+    }
+}
+
+static StepStats reduceChunks(std::vector<StepChunk> &chunks, int chunkCount, std::vector<std::unique_ptr<TerminationPolicy>> &policies, TerminationStats *terminationStats,
+                              std::vector<std::vector<double>> *rayCollection)
+{
+    StepStats total;
+    for (int chunk = 0; chunk < chunkCount; ++chunk)
+    {
+        StepChunk &result = chunks[chunk];
+        total.aliveBirds += result.stats.aliveBirds;
+        total.flaps += result.stats.flaps;
+        total.crashes += result.stats.crashes;
+        total.stopped += result.stats.stopped;
+
+        if (rayCollection)
+            rayCollection->insert(rayCollection->end(), result.rays.begin(), result.rays.end());
+
+        for (size_t p = 0; p < policies.size(); ++p)
+        {
+            if (terminationStats && result.stopped[p] > 0)
+                terminationStats->record(policies[p]->getName(), result.stopped[p], result.secondsSaved[p]);
+        }
+    }
+    return total;
+}
+
+static void createPolicies(const TrainingConfig &config, std::vector<std::unique_ptr<TerminationPolicy>> &policies, DominancePolicy *&dominance)
+{
+    policies.clear();
+    dominance = nullptr;
+
+    if (config.maxEpisodeFrames > 0)
+        policies.push_back(std::make_unique<EpisodeLengthPolicy>(config.maxEpisodeFrames));
+    if (config.noProgressSeconds > 0.0f)
+        policies.push_back(std::make_unique<NoProgressPolicy>(config.maxEpisodeFrames, config.noProgressSeconds));
+    if (config.dominanceCutoff)
+    {
+        auto policy = std::make_unique<DominancePolicy>(config.maxEpisodeFrames);
+        dominance = policy.get();
+        policies.push_back(std::move(policy));
+    }
+}
+
+// Earliest u in [0, length] where a * u^2 + b * u + c rises above zero, INFINITY if it never does
+static float firstCrossing(float a, float b, float c, float length)
+{
+    if (c > 0.0f)
+        return 0.0f;
+
+    float u;
+    if (a == 0.0f)
+    {
+        if (b <= 0.0f)
+            return INFINITY;
+        u = -c / b;
+    }
+    else
+    {
+        float discriminant = b * b - 4.0f * a * c;
+        if (discriminant <= 0.0f)
+            return INFINITY;
+        // Starting at or below zero, an upward parabola rises at its larger root and a downward one at its smaller,
+        // and for either sign that is the same expression
+        u = (-b + sqrtf(discriminant)) / (2.0f * a);
+    }
+    if (u < 0.0f || u > length + IMPACT_TOLERANCE)
+        return INFINITY;
+    return std::min(u, length);
+}
+
+FlappyEnv::FlappyEnv(int environmentCount, int birdsPerEnvironment, float timeStep) : FlappyEnv(ownStates, environmentCount, birdsPerEnvironment, timeStep, 800, 600, 5, 5)
+{
+}
+
+FlappyEnv::FlappyEnv(BirdStates &states, int environmentCount, int birdsPerEnvironment, float timeStep, int windowWidth, int windowHeight, float roofHeight, float groundHeight) : environmentCount(environmentCount), timeStep(timeStep), states(states), windowWidth(windowWidth), windowHeight(windowHeight), roofHeight(roofHeight), groundHeight(groundHeight), frames(0), time(0.0), previousTime(0.0), dominance(nullptr), terminationStats(nullptr), pool(nullptr), collectRays(false)
+{
+    int pipeSlots = environmentCount * VEC_ENV_PIPES;
+    pipeSpawnTime.resize(pipeSlots);
+    pipePhase.resize(pipeSlots);
+    pipeFirst.resize(environmentCount);
+    pipeCount.resize(environmentCount);
+    pipeUnpassed.resize(environmentCount);
+
+    pipeRandom.resize(environmentCount);
+    seeds.resize(environmentCount);
+    nearest.resize(environmentCount);
+    pipePassed.resize(environmentCount);
+    flownPassed.resize(environmentCount);
+    segmentBegin.resize(environmentCount + 1);
+
+    resize(birdsPerEnvironment);
+}
+
+void FlappyEnv::configureTermination(const TrainingConfig &config, TerminationStats *stats)
+{
+    terminationStats = stats;
+    createPolicies(config, policies, dominance);
+}
+
+void FlappyEnv::setEliteThreshold(int threshold)
+{
+    if (dominance)
+        dominance->setEliteThreshold(threshold);
+}
+
+void FlappyEnv::setThreadPool(ThreadPool *pool)
+{
+    this->pool = pool;
+}
+
+void FlappyEnv::setTimeStep(float timeStep)
+{
+    this->timeStep = timeStep;
+}
+
+void FlappyEnv::setRayCollection(bool enabled)
+{
+    collectRays = enabled;
+}
+
+void FlappyEnv::setBirdsPerEnvironment(int birdsPerEnvironment)
+{
+    resize(birdsPerEnvironment);
+    observeAll();
+}
+
+void FlappyEnv::resize(int birdsPerEnvironment)
+{
+    // Whole words per environment, so a chunk never mixes two pipe streams
+    this->birdsPerEnvironment = birdsPerEnvironment;
+    stride = std::max((birdsPerEnvironment + 63) / 64, 1) * 64;
+    slotCount = (environmentCount - 1) * stride + birdsPerEnvironment;
+
+    observations.assign((size_t)slotCount * RAYS_NUMBER, 0.0f);
+    rewards.assign(slotCount, 0.0f);
+    dones.assign(slotCount, 1);
+    rewardedWords.clear();
+
+    states.reset(slotCount);
+    for (int slot = 0; slot < slotCount; ++slot)
+    {
+        if (slot % stride < birdsPerEnvironment)
+            dones[slot] = 0;
+        else
+            states.alive[slot >> 6] &= ~((Uint64)1 << (slot & 63));
+    }
+    states.compact();
+}
+
+EnvStep FlappyEnv::reset(unsigned int seed)
+{
+    std::vector<unsigned int> environmentSeeds(environmentCount);
+    for (int e = 0; e < environmentCount; ++e)
+    {
+        environmentSeeds[e] = seed + (unsigned int)e * 7919u;
+    }
+    return reset(environmentSeeds);
+}
+
+EnvStep FlappyEnv::reset(const std::vector<unsigned int> &seeds)
+{
+    frames = 0;
+    time = 0.0;
+    previousTime = 0.0;
+    for (int e = 0; e < environmentCount; ++e)
+    {
+        this->seeds[e] = seeds[e];
+        pipeRandom[e].seed(seeds[e]);
+        pipeFirst[e] = 0;
+        pipeCount[e] = 0;
+        pipeUnpassed[e] = 0;
+    }
+
+    resize(birdsPerEnvironment);
+    for (auto &policy : policies)
+    {
+        policy->reset();
+    }
+
+    advancePipes(time + timeStep);
+    observeAll();
+    return getLastStep();
+}
+
+int FlappyEnv::getPipeSlot(int environment, int pipe)
+{
+    return environment * VEC_ENV_PIPES + pipe % VEC_ENV_PIPES;
+}
+
+void FlappyEnv::spawnPipe(int environment)
+{
+    // Never happens at the default speeds, but the oldest pipe is the one to give up
+    if (pipeCount[environment] == VEC_ENV_PIPES)
+        retirePipe(environment);
+
+    // Pipe n is due at n spawn intervals, so the schedule never depends on the step length
+    int pipe = pipeFirst[environment] + pipeCount[environment]++;
+    int k = getPipeSlot(environment, pipe);
+    pipeSpawnTime[k] = pipe * (double)PIPE_SPAWN_INTERVAL;
+
+    // gapPosition in [0, 1) picks where the gap starts between roof and ground, on its way down
+    float gapPosition = std::uniform_real_distribution<float>(0.0f, 1.0f)(pipeRandom[environment]);
+    float height = (float)windowHeight;
+    pipePhase[k] = (float)(int)(gapPosition * (int)(height - groundHeight - roofHeight - PIPE_GAP_HEIGHT - 20));
+}
+
+void FlappyEnv::retirePipe(int environment)
+{
+    ++pipeFirst[environment];
+    --pipeCount[environment];
+    pipeUnpassed[environment] = std::max(pipeUnpassed[environment], pipeFirst[environment]);
+}
+
+PipeView FlappyEnv::makeView(float xCordinate, float yCordinateGap)
+{
+    float height = (float)windowHeight;
+    return {xCordinate, PIPE_WIDTH, yCordinateGap, PIPE_GAP_HEIGHT,
+            {xCordinate, roofHeight, PIPE_WIDTH, yCordinateGap - PIPE_GAP_HEIGHT / 2 - roofHeight},
+            {xCordinate, yCordinateGap + PIPE_GAP_HEIGHT / 2, PIPE_WIDTH, height - (yCordinateGap + PIPE_GAP_HEIGHT / 2) - groundHeight}};
+}
+
+float FlappyEnv::getPipeX(int slot, double time)
+{
+    return (float)(windowWidth - PIPE_X_SPEED * (time - pipeSpawnTime[slot]));
+}
+
+double FlappyEnv::getGapTravel(int slot, double time)
+{
+    // The gap bounces between its highest and lowest centre at constant speed, one round trip every 2 * range
+    double range = windowHeight - groundHeight - roofHeight - PIPE_GAP_HEIGHT - 20;
+    double travelled = fmod(pipePhase[slot] + PIPE_Y_SPEED * (time - pipeSpawnTime[slot]), 2 * range);
+    if (travelled < 0)
+        travelled += 2 * range;
+    return travelled;
+}
+
+float FlappyEnv::getPipeGap(int slot, double time)
+{
+    double highest = roofHeight + 10 + PIPE_GAP_HEIGHT / 2;
+    double range = windowHeight - groundHeight - roofHeight - PIPE_GAP_HEIGHT - 20;
+    double travelled = getGapTravel(slot, time);
+    return (float)(highest + (travelled <= range ? travelled : 2 * range - travelled));
+}
+
+void FlappyEnv::sweepPipes()
+{
+    double highest = roofHeight + 10 + PIPE_GAP_HEIGHT / 2;
+    double range = windowHeight - groundHeight - roofHeight - PIPE_GAP_HEIGHT - 20;
+    double deltaTime = time - previousTime;
+
+    segments.clear();
+    for (int e = 0; e < environmentCount; ++e)
+    {
+        segmentBegin[e] = (int)segments.size();
+        for (int pipe = pipeFirst[e]; pipe < pipeFirst[e] + pipeCount[e]; ++pipe)
+        {
+            int k = getPipeSlot(e, pipe);
+
+            // The pipe moves at a constant speed, so it overlaps the birds' column for one interval of the step
+            double x = getPipeX(k, previousTime);
+            double enter = std::max((x - (BIRD_X + BIRD_SIZE / 2)) / PIPE_X_SPEED, 0.0);
+            double exit = std::min((x + PIPE_WIDTH - (BIRD_X - BIRD_SIZE / 2)) / PIPE_X_SPEED, deltaTime);
+
+            // Cut the overlap at every bounce, legs alternate between down and up and each takes range / speed
+            double travelled = getGapTravel(k, previousTime + enter);
+            int leg = (int)(travelled / range);
+            double legStart = enter - (travelled - leg * range) / PIPE_Y_SPEED;
+            while (enter < exit)
+            {
+                double legEnd = legStart + range / PIPE_Y_SPEED;
+                double along = (enter - legStart) * PIPE_Y_SPEED;
+
+                GapSegment segment;
+                segment.begin = (float)enter;
+                segment.end = (float)std::min(legEnd, exit);
+                segment.gap = (float)(leg % 2 == 0 ? highest + along : highest + range - along);
+                segment.gapVelocity = leg % 2 == 0 ? PIPE_Y_SPEED : -PIPE_Y_SPEED;
+                segments.push_back(segment);
+
+                enter = legEnd;
+                legStart = legEnd;
+                ++leg;
+            }
+        }
+    }
+    segmentBegin[environmentCount] = (int)segments.size();
+}
+
+void FlappyEnv::advancePipes(double time)
+{
+    for (int e = 0; e < environmentCount; ++e)
+    {
+        while ((pipeFirst[e] + pipeCount[e]) * (double)PIPE_SPAWN_INTERVAL <= time)
+            spawnPipe(e);
+
+        // Every bird shares the same x and pipes cross it in spawn order, so the passes are counted off the
+        // first unpassed pipe, once for all of the birds
+        int last = pipeFirst[e] + pipeCount[e];
+        pipePassed[e] = 0;
+        while (pipeUnpassed[e] < last && getPipeX(getPipeSlot(e, pipeUnpassed[e]), time) + PIPE_WIDTH < BIRD_X)
+        {
+            ++pipePassed[e];
+            ++pipeUnpassed[e];
+        }
+
+        // A pipe whose edge sits exactly on the birds is neither passed nor ahead of them
+        int closest = pipeUnpassed[e];
+        if (closest + 1 < last && !(getPipeX(getPipeSlot(e, closest), time) + PIPE_WIDTH > BIRD_X))
+            ++closest;
+
+        int k = getPipeSlot(e, closest);
+        nearest[e] = makeView(getPipeX(k, time), getPipeGap(k, time));
+    }
+}
+
+void FlappyEnv::observe(int slot, const PipeView &view, StepChunk *chunk)
+{
+    Ray ray[RAYS_NUMBER];
+    generate_rays(BIRD_X, states.y[slot], ray, view);
+
+    float *row = &observations[(size_t)slot * RAYS_NUMBER];
+    for (int r = 0; r < RAYS_NUMBER; ++r)
+    {
+        if (chunk)
+            chunk->rays.push_back({ray[r].startX, ray[r].startY, ray[r].endX, ray[r].endY});
+        row[r] = sqrt(pow(ray[r].endX - ray[r].startX, 2) + pow(ray[r].endY - ray[r].startY, 2));
+    }
+}
+
+void FlappyEnv::observeAll()
+{
+    int chunkCount = (int)states.liveWords.size();
+    if ((int)chunks.size() < chunkCount)
+        chunks.resize(chunkCount);
+
+    runChunks(pool, chunkCount, [&](int chunk, int)
+              {
+                  chunks[chunk].rays.clear();
+                  int word = states.liveWords[chunk];
+                  const PipeView &view = nearest[word * 64 / stride];
+                  for (Uint64 bits = states.alive[word]; bits; bits &= bits - 1)
+                  {
+                      observe(word * 64 + lowestSetBit(bits), view, collectRays ? &chunks[chunk] : nullptr);
+                  } });
+
+    rays.clear();
+    for (int chunk = 0; collectRays && chunk < chunkCount; ++chunk)
+    {
+        rays.insert(rays.end(), chunks[chunk].rays.begin(), chunks[chunk].rays.end());
+    }
+}
+
+EnvStep FlappyEnv::step(const Uint8 *actions)
+{
+    ++frames;
+    previousTime = time;
+    time += timeStep;
+
+    // Rewards only hold the gains of this step, so the ones written last step are cleared first
+    for (int word : rewardedWords)
+    {
+        std::fill(rewards.begin() + word * 64, rewards.begin() + std::min(word * 64 + 64, slotCount), 0.0f);
+    }
+    rewardedWords = states.liveWords;
+
+    // The birds fly through the step prepared last time, then the pipes are looked up again so the survivors can
+    // observe the next one
+    std::swap(pipePassed, flownPassed);
+    sweepPipes();
+    for (int e = 0; e < environmentCount; ++e)
+    {
+        // Pipes leave in the order they came, so the off-screen ones are at the front
+        while (pipeCount[e] > 0 && getPipeX(getPipeSlot(e, pipeFirst[e]), time) + PIPE_WIDTH < 0)
+            retirePipe(e);
+    }
+    advancePipes(time + timeStep);
+
+    for (auto &policy : policies)
+    {
+        policy->prepare(slotCount);
+    }
+
+    // Only words with a bird still flying become chunks, so the cost follows the live birds
+    int chunkCount = (int)states.liveWords.size();
+    if ((int)chunks.size() < chunkCount)
+        chunks.resize(chunkCount);
+
+    // Birds never touch each other, so chunks run in any order and on any thread
+    runChunks(pool, chunkCount, [&](int chunk, int)
+              { stepChunk(chunk, actions); });
+
+    rays.clear();
+    stepStats = reduceChunks(chunks, chunkCount, policies, terminationStats, collectRays ? &rays : nullptr);
+    states.compact();
+
+    return getLastStep();
+}
+
+// One chunk of a step : one bitset word of slots, all in the same environment and looking at the same pipe
+void FlappyEnv::stepChunk(int chunk, const Uint8 *actions)
+{
+    StepChunk &result = chunks[chunk];
+    result.stats = StepStats();
+    result.stopped.assign(policies.size(), 0);
+    result.secondsSaved.assign(policies.size(), 0.0);
+    result.rays.clear();
+
+    // Only this chunk writes its word, the live list is compacted once all chunks are done
+    int word = states.liveWords[chunk];
+    int begin = word * 64;
+    int environment = begin / stride;
+    Uint64 flying = states.alive[word];
+
+    float *y = states.y.data();
+    float *previousY = states.previousY.data();
+    float *velocity = states.velocity.data();
+    int *score = states.score.data();
+    int *fitness = states.fitness.data();
+    int *framesAlive = states.framesAlive.data();
+    float deltaTime = timeStep;
+    float floorHeight = windowHeight - groundHeight;
+
+    for (Uint64 bits = flying; bits; bits &= bits - 1)
+    {
+        int index = begin + lowestSetBit(bits);
+        if (actions[index])
+        {
+            velocity[index] = BIRD_JUMP_STRENGTH;
+            ++result.stats.flaps;
+        }
+    }
+
+    const GapSegment *pipeSegments = segments.data() + segmentBegin[environment];
+    int segmentCount = segmentBegin[environment + 1] - segmentBegin[environment];
+    int passed = flownPassed[environment];
+
+    // How far the bird's centre may stray from the gap's before its box touches a pipe
+    const float clearance = (PIPE_GAP_HEIGHT - BIRD_SIZE) / 2;
+    const float halfGravity = BIRD_GRAVITY / 2;
+
+    // Physics, collision and scoring only stream the state arrays
+    Uint64 crashed = 0;
+    for (Uint64 bits = flying; bits; bits &= bits - 1)
+    {
+        int index = begin + lowestSetBit(bits);
+        int previousFitness = fitness[index];
+        float startY = y[index];
+        float startVelocity = velocity[index];
+
+        // The bird follows an exact parabola through the step, so the earliest moment its centre leaves the screen
+        // or its box meets a pipe is solved for instead of sampled at the end of the step
+        float impact = firstCrossing(halfGravity, startVelocity, startY - floorHeight, deltaTime);
+        impact = std::min(impact, firstCrossing(-halfGravity, -startVelocity, roofHeight - startY, deltaTime));
+        for (int s = 0; s < segmentCount; ++s)
+        {
+            const GapSegment &segment = pipeSegments[s];
+            float offset = startY + startVelocity * segment.begin + halfGravity * segment.begin * segment.begin - segment.gap;
+            float closing = startVelocity + BIRD_GRAVITY * segment.begin - segment.gapVelocity;
+            float length = segment.end - segment.begin;
+            impact = std::min(impact, segment.begin + firstCrossing(halfGravity, closing, offset - clearance, length));
+            impact = std::min(impact, segment.begin + firstCrossing(-halfGravity, -closing, -offset - clearance, length));
+        }
+
+        bool dead = impact <= deltaTime;
+        float flight = dead ? impact : deltaTime;
+
+        previousY[index] = startY;
+        y[index] = startY + startVelocity * flight + halfGravity * flight * flight;
+        velocity[index] = startVelocity + BIRD_GRAVITY * flight;
+        ++framesAlive[index];
+
+        if (!dead)
+            score[index] += passed;
+        fitness[index] = score[index] * PIPE_SCORE + framesAlive[index];
+        rewards[index] = (float)(fitness[index] - previousFitness);
+
+        if (dead)
+            crashed |= (Uint64)1 << (index - begin);
+    }
+
+    for (Uint64 bits = flying; bits; bits &= bits - 1)
+    {
+        int index = begin + lowestSetBit(bits);
+        bool dead = (crashed >> (index - begin)) & 1;
+
+        if (dead)
+            ++result.stats.crashes;
+
+        for (size_t p = 0; p < policies.size() && !dead; ++p)
+        {
+            if (policies[p]->shouldStop(states, index, deltaTime))
+            {
+                dead = true;
+                ++result.stats.stopped;
+                ++result.stopped[p];
+                result.secondsSaved[p] += policies[p]->getSecondsSaved(states, index, deltaTime);
+            }
+        }
+
+        if (dead)
+        {
+            states.alive[word] &= ~((Uint64)1 << (index - begin));
+            dones[index] = 1;
+        }
+        else
+        {
+            ++result.stats.aliveBirds;
+        }
+    }
+
+    // Survivors observe the pipe they will face next step
+    const PipeView &next = nearest[environment];
+    for (Uint64 bits = states.alive[word]; bits; bits &= bits - 1)
+    {
+        observe(begin + lowestSetBit(bits), next, collectRays ? &result : nullptr);
+    }
+}
+
+void FlappyEnv::resetSlot(int slot)
+{
+    states.resetSlot(slot);
+    rewards[slot] = 0.0f;
+    dones[slot] = 0;
+    observe(slot, nearest[slot / stride], nullptr);
+}
+
+EnvStep FlappyEnv::getLastStep()
+{
+    return {observations.data(), rewards.data(), dones.data(), slotCount, RAYS_NUMBER};
+}
+
+int FlappyEnv::getEnvironmentCount()
+{
+    return environmentCount;
+}
+
+int FlappyEnv::getBirdsPerEnvironment()
+{
+    return birdsPerEnvironment;
+}
+
+int FlappyEnv::getStride()
+{
+    return stride;
+}
+
+int FlappyEnv::getSlotCount()
+{
+    return slotCount;
+}
+
+int FlappyEnv::getFrames()
+{
+    return frames;
+}
+
+double FlappyEnv::getTime()
+{
+    return time;
+}
+
+unsigned int FlappyEnv::getSeed(int environment)
+{
+    return seeds[environment];
+}
+
+float FlappyEnv::getTimeStep()
+{
+    return timeStep;
+}
+
+bool FlappyEnv::isDone(int slot)
+{
+    return dones[slot] != 0;
+}
+
+int FlappyEnv::getAliveCount(int environment)
+{
+    int count = 0;
+    int begin = environment * stride;
+    for (int word = begin / 64; word < (begin + birdsPerEnvironment + 63) / 64; ++word)
+    {
+        count += countSetBits(states.alive[word]);
+    }
+    return count;
+}
+
+BirdStates &FlappyEnv::getStates()
+{
+    return states;
+}
+
+const StepStats &FlappyEnv::getStepStats()
+{
+    return stepStats;
+}
+
+const std::vector<std::vector<double>> &FlappyEnv::getRays()
+{
+    return rays;
+}
+
+int FlappyEnv::getPipeCount(int environment)
+{
+    return pipeCount[environment];
+}
+
+PipeView FlappyEnv::getPipeViewAt(int environment, int k, double time)
+{
+    int slot = getPipeSlot(environment, pipeFirst[environment] + k);
+    return makeView(getPipeX(slot, time), getPipeGap(slot, time));
+}
+
+PipeView FlappyEnv::getPipeView(int environment, int k, float alpha)
+{
+    return getPipeViewAt(environment, k, previousTime + (time - previousTime) * alpha);
+}
+
+// ----- FlappyEnv Class Decleration End -----
+
+// ----- Simulation Class Decleration Start -----
+
+Simulation::Simulation(std::vector<Bird> &birds, BirdStates &states, int windowWidth, int windowHeight, float roofHeight, float groundHeight) : Simulation(birds, states, 1, (int)birds.size(), windowWidth, windowHeight, roofHeight, groundHeight)
+{
+    reset();
+}
+
+Simulation::Simulation(std::vector<Bird> &birds, BirdStates &states, int environmentCount, int birdsPerEnvironment, int windowWidth, int windowHeight, float roofHeight, float groundHeight) : birds(birds), environment(states, environmentCount, birdsPerEnvironment, HEADLESS_DELTA_TIME, windowWidth, windowHeight, roofHeight, groundHeight), pool(nullptr)
+{
+}
+
+int Simulation::getFitnessGainBound(int frames, float deltaTime)
+{
+    // One point per frame, and at most one pipe per spawn interval plus the one already on its way
+    int pipes = (int)(frames * deltaTime / PIPE_SPAWN_INTERVAL) + 1;
+    return frames + pipes * PIPE_SCORE;
+}
+
+void Simulation::configureTermination(const TrainingConfig &config, TerminationStats *stats)
+{
+    environment.configureTermination(config, stats);
+}
+
+void Simulation::setEliteThreshold(int threshold)
+{
+    environment.setEliteThreshold(threshold);
+}
+
+void Simulation::setThreadPool(ThreadPool *pool)
+{
+    this->pool = pool;
+    environment.setThreadPool(pool);
+}
+
+void Simulation::reset()
+{
+    reset((unsigned int)randomInt(0x7FFFFFFF));
+}
+
+void Simulation::reset(unsigned int seed)
+{
+    environment.reset(seed);
+}
+
+void Simulation::reset(const std::vector<unsigned int> &seeds)
+{
+    environment.reset(seeds);
+}
+
+// Networks decide the flaps from the observations the environment prepared, the only part that touches each Bird's genome
+void Simulation::chooseActions()
+{
+    BirdStates &states = environment.getStates();
+    flyingWords = states.liveWords;
+    flyingBits.resize(flyingWords.size());
+    for (size_t i = 0; i < flyingWords.size(); ++i)
+    {
+        flyingBits[i] = states.alive[flyingWords[i]];
+    }
+
+    if ((int)actions.size() < environment.getSlotCount())
+        actions.resize(environment.getSlotCount());
+    int threadCount = pool ? pool->getThreadCount() : 1;
+    if ((int)scratch.size() < threadCount)
+        scratch.resize(threadCount);
+
+    const float *observations = environment.getLastStep().observations;
+    runChunks(pool, (int)flyingWords.size(), [&](int chunk, int thread)
+              {
+                  std::vector<float> &input = scratch[thread].input;
+                  for (Uint64 bits = flyingBits[chunk]; bits; bits &= bits - 1)
+                  {
+                      int slot = flyingWords[chunk] * 64 + lowestSetBit(bits);
+
+                      // Slots refilled since the last step have not been observed yet
+                      if (environment.isDone(slot))
+                          environment.resetSlot(slot);
+
+                      const float *row = observations + (size_t)slot * RAYS_NUMBER;
+                      input.assign(row, row + RAYS_NUMBER);
+                      actions[slot] = birds[slot].feedForward(input)[0] > 0.5f;
+                  } });
+}
+
+void Simulation::recordFlights()
+{
+    const BirdStates &states = environment.getStates();
+    runChunks(pool, (int)flyingWords.size(), [&](int chunk, int)
+              {
+                  for (Uint64 bits = flyingBits[chunk]; bits; bits &= bits - 1)
+                  {
+                      int slot = flyingWords[chunk] * 64 + lowestSetBit(bits);
+
+                      if (states.framesAlive[slot] % BEHAVIOUR_INTERVAL == 0)
+                          birds[slot].sampleBehaviour(states.y[slot] / 600.0f);
+                      if (!states.isAlive(slot))
+                          birds[slot].recordFlight(states.y[slot], states.score[slot], states.fitness[slot], states.framesAlive[slot], true);
+                  } });
+}
+
+bool Simulation::step(float deltaTime, std::vector<std::vector<double>> *rayCollection)
+{
+    if (deltaTime != environment.getTimeStep())
+        environment.setTimeStep(deltaTime);
+    environment.setRayCollection(rayCollection != nullptr);
+
+    chooseActions();
+    environment.step(actions.data());
+    recordFlights();
+
+    if (rayCollection)
+        rayCollection->insert(rayCollection->end(), environment.getRays().begin(), environment.getRays().end());
+
+    return environment.getStates().aliveCount > 0;
+}
+
+void Simulation::runEpisode(float deltaTime, int maxEpisodeFrames)
+{
+    runEpisode(deltaTime, maxEpisodeFrames, (unsigned int)randomInt(0x7FFFFFFF));
+}
+
+void Simulation::runEpisode(float deltaTime, int maxEpisodeFrames, unsigned int seed)
+{
+    // The reset already moves the pipes one step ahead, so the step length has to be known first
+    environment.setTimeStep(deltaTime);
+    reset(seed);
+    while (step(deltaTime, nullptr) && (maxEpisodeFrames <= 0 || environment.getFrames() < maxEpisodeFrames))
+    {
+    }
+    storeResults();
+}
+
+void Simulation::runEpisode(float deltaTime, int maxEpisodeFrames, const std::vector<unsigned int> &seeds)
+{
+    environment.setTimeStep(deltaTime);
+    reset(seeds);
+    while (step(deltaTime, nullptr) && (maxEpisodeFrames <= 0 || environment.getFrames() < maxEpisodeFrames))
+    {
+    }
+    storeResults();
+}
+
+void Simulation::storeResults()
+{
+    const BirdStates &states = environment.getStates();
+    for (int word : states.liveWords)
+    {
+        for (Uint64 bits = states.alive[word]; bits; bits &= bits - 1)
+        {
+            int index = word * 64 + lowestSetBit(bits);
+            if (index < (int)birds.size())
+                birds[index].recordFlight(states.y[index], states.score[index], states.fitness[index], states.framesAlive[index], false);
+        }
+    }
+}
+
+FlappyEnv &Simulation::getEnvironment()
+{
+    return environment;
+}
+
+int Simulation::getSurvivalFrames()
+{
+    return environment.getFrames();
+}
+
+unsigned int Simulation::getSeed()
+{
+    return environment.getSeed(0);
+}
+
+const StepStats &Simulation::getStepStats()
+{
+    return environment.getStepStats();
+}
+
+// ----- Simulation Class Decleration End -----
+
+// ----- VecEnv Class Decleration Start -----
+
+VecEnv::VecEnv(const std::vector<Bird> &flock, int environmentCount, int windowWidth, int windowHeight, float roofHeight, float groundHeight) : simulation(birds, states, environmentCount, (int)flock.size(), windowWidth, windowHeight, roofHeight, groundHeight)
+{
+    int stride = simulation.getEnvironment().getStride();
+    int birdsPerEnvironment = (int)flock.size();
+
+    birds.reserve((size_t)environmentCount * stride);
+    for (int e = 0; e < environmentCount; ++e)
+    {
+        for (int i = 0; i < stride; ++i)
+        {
+            birds.push_back(flock[std::min(i, birdsPerEnvironment - 1)]);
+            birds.back().reset();
+        }
+    }
+}
+
+void VecEnv::configureTermination(const TrainingConfig &config, TerminationStats *stats)
+{
+    simulation.configureTermination(config, stats);
+}
+
+void VecEnv::setThreadPool(ThreadPool *pool)
+{
+    simulation.setThreadPool(pool);
+}
+
+void VecEnv::reset(const std::vector<unsigned int> &seeds)
+{
+    simulation.reset(seeds);
+}
+
+bool VecEnv::step(float deltaTime)
+{
+    return simulation.step(deltaTime, nullptr);
+}
+
+void VecEnv::runEpisode(float deltaTime, int maxEpisodeFrames, const std::vector<unsigned int> &seeds)
+{
+    simulation.runEpisode(deltaTime, maxEpisodeFrames, seeds);
+}
+
+void VecEnv::storeResults()
+{
+    simulation.storeResults();
+}
+
+Bird &VecEnv::getBird(int environment, int index)
+{
+    return birds[environment * simulation.getEnvironment().getStride() + index];
+}
+
+int VecEnv::getEnvironmentCount()
+{
+    return simulation.getEnvironment().getEnvironmentCount();
+}
+
+int VecEnv::getBirdsPerEnvironment()
+{
+    return simulation.getEnvironment().getBirdsPerEnvironment();
+}
+
+int VecEnv::getAliveCount(int environment)
+{
+    return simulation.getEnvironment().getAliveCount(environment);
+}
+
+const StepStats &VecEnv::getStepStats()
+{
+    return simulation.getStepStats();
+}
+
+int VecEnv::getFrames()
+{
+    return simulation.getEnvironment().getFrames();
+}
+
+// ----- VecEnv Class Decleration End -----
+
+// ----- ThreadPool Class Decleration Start -----
+
+ThreadPool::ThreadPool(int threadCount) : task(nullptr), generation(0), busy(0), stopping(false)
+{
+    mutex = SDL_CreateMutex();
+    wake = SDL_CreateCondition();
+    done = SDL_CreateCondition();
+    SDL_SetAtomicInt(&nextWorker, 1);
+
+    if (threadCount <= 0)
+        threadCount = SDL_GetNumLogicalCPUCores();
+
+    // Sized up front, the threads index into it as soon as they start
+    queues.resize(std::max(threadCount, 1));
+    for (auto &queue : queues)
+    {
+        queue.lock = 0;
+        queue.begin = 0;
+        queue.end = 0;
+    }
+
+    // The thread calling parallelFor works too, so it counts as one of them
+    for (int i = 1; i < threadCount; ++i)
+    {
+        SDL_Thread *thread = SDL_CreateThread(threadEntry, "ThreadPool", this);
+        if (!thread)
+        {
+            SDL_Log("Unable to start pool thread: %s", SDL_GetError());
+            break;
+        }
+        threads.push_back(thread);
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    SDL_LockMutex(mutex);
+    stopping = true;
+    SDL_BroadcastCondition(wake);
+    SDL_UnlockMutex(mutex);
+
+    for (auto thread : threads)
+    {
+        SDL_WaitThread(thread, NULL);
+    }
+
+    SDL_DestroyCondition(done);
+    SDL_DestroyCondition(wake);
+    SDL_DestroyMutex(mutex);
+}
+
+int ThreadPool::threadEntry(void *data)
+{
+    ThreadPool *pool = static_cast<ThreadPool *>(data);
+    pool->work(SDL_AddAtomicInt(&pool->nextWorker, 1));
+    return 0;
+}
+
+void ThreadPool::work(int worker)
+{
+    int seen = 0;
+
+    SDL_LockMutex(mutex);
+    while (true)
+    {
+        while (!stopping && generation == seen)
+            SDL_WaitCondition(wake, mutex);
+        if (stopping)
+            break;
+
+        seen = generation;
+        // A thread that wakes after the job already finished finds no task and goes back to sleep
+        const std::function<void(int, int)> *current = task;
+        if (!current)
+            continue;
+
+        ++busy;
+        SDL_UnlockMutex(mutex);
+        drain(worker, *current);
+        SDL_LockMutex(mutex);
+
+        if (--busy == 0)
+            SDL_BroadcastCondition(done);
+    }
+    SDL_UnlockMutex(mutex);
+}
+
+bool ThreadPool::takeTask(int worker, int &index)
+{
+    WorkQueue &own = queues[worker];
+
+    SDL_LockSpinlock(&own.lock);
+    bool found = own.begin < own.end;
+    if (found)
+        index = own.begin++;
+    SDL_UnlockSpinlock(&own.lock);
+
+    if (found)
+        return true;
+
+    // Own range is empty : steal the back half of the first victim that still has work
+    int count = (int)queues.size();
+    for (int offset = 1; offset < count; ++offset)
+    {
+        WorkQueue &victim = queues[(worker + offset) % count];
+
+        SDL_LockSpinlock(&victim.lock);
+        int begin = victim.begin + (victim.end - victim.begin) / 2;
+        int end = victim.end;
+        if (begin < end)
+            victim.end = begin;
+        SDL_UnlockSpinlock(&victim.lock);
+
+        if (begin >= end)
+            continue;
+
+        index = begin;
+        if (begin + 1 < end)
+        {
+            SDL_LockSpinlock(&own.lock);
+            own.begin = begin + 1;
+            own.end = end;
+            SDL_UnlockSpinlock(&own.lock);
+        }
+        return true;
+    }
+
+    return false;
+}
+
+void ThreadPool::drain(int worker, const std::function<void(int, int)> &current)
+{
+    int index;
+    while (takeTask(worker, index))
+    {
+        current(index, worker);
+    }
+}
+
+void ThreadPool::parallelFor(int count, const std::function<void(int)> &task)
+{
+    parallelFor(count, [&task](int index, int)
+                { task(index); });
+}
+
+void ThreadPool::parallelFor(int count, const std::function<void(int, int)> &task)
+{
+    if (count <= 0)
+        return;
+
+    // Nothing to share, so skip waking the pool
+    if (count == 1 || threads.empty())
+    {
+        for (int i = 0; i < count; ++i)
+        {
+            task(i, 0);
+        }
+        return;
+    }
+
+    SDL_LockMutex(mutex);
+
+    // Contiguous slices, so every thread starts on its own part of the range and only steals once it runs dry
+    int participants = (int)queues.size();
+    for (int p = 0; p < participants; ++p)
+    {
+        queues[p].begin = (int)((long long)count * p / participants);
+        queues[p].end = (int)((long long)count * (p + 1) / participants);
+    }
+
+    this->task = &task;
+    ++generation;
+    SDL_BroadcastCondition(wake);
+    SDL_UnlockMutex(mutex);
+
+    drain(0, task);
+
+    // Every index has been taken once the caller runs dry, the ones still running belong to busy threads
+    SDL_LockMutex(mutex);
+    while (busy > 0)
+    {
+        SDL_WaitCondition(done, mutex);
+    }
+
+    this->task = nullptr;
+    SDL_UnlockMutex(mutex);
+}
+
+int ThreadPool::getThreadCount()
+{
+    return (int)threads.size() + 1;
+}
+
+// ----- ThreadPool Class Decleration End -----
+
+// ----- MultiSeedEvaluator Class Decleration Start -----
+
+MultiSeedEvaluator::MultiSeedEvaluator(const TrainingConfig &config, ThreadPool *pool, int eliteCount) : config(config), aggregation(config.aggregation), quantile(config.quantile), timeStep(1.0f / std::max(config.tickRate, 1)), pool(pool), eliteCount(eliteCount), steps(0)
+{
+}
+
+int MultiSeedEvaluator::aggregate(std::vector<int> &scores)
+{
+    if (aggregation == "min")
+        return *std::min_element(scores.begin(), scores.end());
+
+    if (aggregation == "quantile")
+    {
+        int index = std::min((int)(quantile * scores.size()), (int)scores.size() - 1);
+        std::nth_element(scores.begin(), scores.begin() + index, scores.end());
+        return scores[index];
+    }
+
+    long long total = 0;
+    for (int score : scores)
+    {
+        total += score;
+    }
+    return (int)(total / (long long)scores.size());
+}
+
+void MultiSeedEvaluator::evaluate(std::vector<Bird> &birds, const std::vector<unsigned int> &seeds)
+{
+    int seedCount = (int)seeds.size();
+    int birdCount = (int)birds.size();
+
+    // Pruning needs every bird's total after each seed, otherwise all seeds run in one round
+    bool prune = config.dominanceCutoff && aggregation == "mean" && eliteCount > 0 && eliteCount < birdCount && config.maxEpisodeFrames > 0;
+    int seedsPerRound = prune ? 1 : seedCount;
+
+    std::vector<std::vector<int>> scores(birdCount, std::vector<int>(seedCount, 0));
+    std::vector<long long> totals(birdCount, 0);
+    std::vector<long long> framesFlown(birdCount, 0); // Summed over every seed the bird has flown
+    std::vector<std::vector<float>> behaviours(birdCount); // From the first seed, the only one no bird is pruned before
+
+    std::vector<int> active(birdCount);
+    for (int i = 0; i < birdCount; ++i)
+    {
+        active[i] = i;
+    }
+    steps = 0;
+
+    for (int firstSeed = 0; firstSeed < seedCount && !active.empty(); firstSeed += seedsPerRound)
+    {
+        int activeCount = (int)active.size();
+
+        // Birds never interact, so every chunk of birds is an independent job that flies all seeds of the round at once
+        int chunks = std::max(1, std::min(activeCount, pool->getThreadCount() * 2));
+        int chunkSize = (activeCount + chunks - 1) / chunks;
+        chunks = (activeCount + chunkSize - 1) / chunkSize;
+
+        std::vector<unsigned int> roundSeeds(seeds.begin() + firstSeed, seeds.begin() + firstSeed + seedsPerRound);
+        std::vector<long long> jobSteps(chunks, 0);
+
+        pool->parallelFor(chunks, [&](int job)
+                          {
+            int begin = job * chunkSize;
+            int end = std::min(begin + chunkSize, activeCount);
+
+            std::vector<Bird> flock;
+            flock.reserve(end - begin);
+            for (int i = begin; i < end; ++i)
+            {
+                flock.push_back(birds[active[i]]);
+            }
+
+            VecEnv environments(flock, seedsPerRound, 800, 600, 5, 5);
+            environments.configureTermination(config, &termination);
+            environments.runEpisode(timeStep, config.maxEpisodeFrames, roundSeeds);
+            jobSteps[job] = environments.getFrames();
+
+            for (int k = 0; k < seedsPerRound; ++k)
+            {
+                for (int i = begin; i < end; ++i)
+                {
+                    Bird &flown = environments.getBird(k, i - begin);
+                    scores[active[i]][firstSeed + k] = flown.getFitness();
+                    framesFlown[active[i]] += flown.getFramesAlive();
+                    if (firstSeed + k == 0)
+                        behaviours[active[i]] = flown.getBehaviour();
+                }
+            } });
+
+        for (long long jobStep : jobSteps)
+        {
+            steps += jobStep;
+        }
+
+        if (!prune || firstSeed + 1 >= seedCount)
+            continue;
+
+        // Scores are never negative, so a total so far is a lower bound on the final total
+        for (int i : active)
+        {
+            totals[i] += scores[i][firstSeed];
+        }
+        std::vector<long long> ranked(totals);
+        std::nth_element(ranked.begin(), ranked.begin() + (eliteCount - 1), ranked.end(), std::greater<long long>());
+        long long eliteBound = ranked[eliteCount - 1];
+
+        int remainingSeeds = seedCount - firstSeed - 1;
+        long long gainBound = (long long)remainingSeeds * Simulation::getFitnessGainBound(config.maxEpisodeFrames, timeStep);
+
+        std::vector<int> survivors;
+        int dominated = 0;
+        double secondsSaved = 0.0;
+        for (int i : active)
+        {
+            // At least eliteCount birds already have more than this one could finish with
+            if (totals[i] + gainBound < eliteBound)
+            {
+                ++dominated;
+                secondsSaved += (double)framesFlown[i] / (firstSeed + 1) * remainingSeeds * timeStep;
+            }
+            else
+            {
+                survivors.push_back(i);
+            }
+        }
+
+        if (dominated > 0)
+            termination.record("dominance", dominated, secondsSaved);
+        active.swap(survivors);
+    }
+
+    for (int i = 0; i < birdCount; ++i)
+    {
+        // Skipped seeds count as zero, pruned birds are ranked below the elites either way
+        birds[i].setFitness(aggregate(scores[i]));
+        // The birds flew as copies, novelty search reads the descriptor off the originals
+        birds[i].setBehaviour(behaviours[i]);
+    }
+}
+
+std::vector<unsigned int> MultiSeedEvaluator::getSeeds(unsigned int generationSeed, int count)
+{
+    std::vector<unsigned int> seeds(count);
+    for (int k = 0; k < count; ++k)
+    {
+        seeds[k] = generationSeed + k * 7919u;
+    }
+    return seeds;
+}
+
+TerminationStats &MultiSeedEvaluator::getTerminationStats()
+{
+    return termination;
+}
+
+long long MultiSeedEvaluator::getSteps()
+{
+    return steps;
+}
+
+// ----- MultiSeedEvaluator Class Decleration End -----
+
+// ----- Island Class Decleration Start -----
+
+MigrationQueue::MigrationQueue(int capacity, const Bird &prototype) : slots(capacity + 1, prototype)
+{
+    SDL_SetAtomicInt(&head, 0);
+    SDL_SetAtomicInt(&tail, 0);
+}
+
+bool MigrationQueue::push(const Bird &migrant)
+{
+    int currentTail = SDL_GetAtomicInt(&tail);
+    int nextTail = (currentTail + 1) % (int)slots.size();
+    if (nextTail == SDL_GetAtomicInt(&head))
+        return false; // Full, the neighbour has not caught up yet
+
+    slots[currentTail] = migrant;
+    SDL_SetAtomicInt(&tail, nextTail);
+    return true;
+}
+
+bool MigrationQueue::pop(Bird &migrant)
+{
+    int currentHead = SDL_GetAtomicInt(&head);
+    if (currentHead == SDL_GetAtomicInt(&tail))
+        return false;
+
+    migrant = slots[currentHead];
+    SDL_SetAtomicInt(&head, (currentHead + 1) % (int)slots.size());
+    return true;
+}
+
+Island::Island(int id, unsigned int seed, const TrainingConfig &config) : id(id), seed(seed), migrationInterval(config.migrationInterval), maxGenerations(config.maxGenerations), maxEpisodeFrames(config.maxEpisodeFrames), timeStep(1.0f / std::max(config.tickRate, 1)), population(config), simulation(population.getPopulation(), population.getStates(), 800, 600, 5, 5), pool(config.threads), evaluationSeeds(config.evaluationSeeds), evaluationSeed(config.evaluationSeed), inbox(nullptr), outbox(nullptr), thread(nullptr)
+{
+    SDL_SetAtomicInt(&generation, 1);
+    SDL_SetAtomicInt(&bestFitness, 0);
+    SDL_SetAtomicInt(&cacheHitRate, 0);
+    SDL_SetAtomicInt(&running, 0);
+
+    simulation.configureTermination(config, &termination);
+    population.getOptimiser().setThreadPool(&pool);
+
+    if (evaluationSeeds > 1)
+        evaluator = std::make_unique<MultiSeedEvaluator>(config, &pool, population.getOptimiser().getEliteCount());
 }
 
-float Bird::sigmoid(float x)
+void Island::connect(MigrationQueue *inbox, MigrationQueue *outbox)
 {
-    return 1.0f / (1.0f + std::exp(-x));
+    this->inbox = inbox;
+    this->outbox = outbox;
 }
 
-float Bird::randomFloat()
+void Island::start()
 {
-    return (float)rand() / RAND_MAX * 2.0f - 1.0f;
+    SDL_SetAtomicInt(&running, 1);
+    thread = SDL_CreateThread(threadEntry, "Island", this);
+    if (!thread)
+    {
+        SDL_Log("Unable to start island %i: %s", id, SDL_GetError());
+        SDL_SetAtomicInt(&running, 0);
+    }
 }
 
-float Bird::randomChance()
+void Island::stop()
 {
-    return (float)rand() / RAND_MAX;
+    SDL_SetAtomicInt(&running, 0);
 }
 
-int Bird::getFitness()
+void Island::join()
 {
-    return fitness;
+    if (thread)
+    {
+        SDL_WaitThread(thread, NULL);
+        thread = nullptr;
+    }
 }
 
-bool Bird::getGameOver()
+int Island::threadEntry(void *data)
 {
-    return gameOver;
+    static_cast<Island *>(data)->evolve();
+    return 0;
 }
 
-void Bird::setGameOver(bool condition)
+void Island::evolve()
 {
-    gameOver = condition;
+    // Pipes and mutations on this thread draw from the island's own stream
+    seedRandom(seed);
+
+    while (SDL_GetAtomicInt(&running))
+    {
+        // One set of seeds per generation, so every genome is compared on the same pipes
+        unsigned int generationSeed = evaluationSeed ? evaluationSeed : (unsigned int)randomInt(0x7FFFFFFF);
+
+        population.applyFitnessCache(generationSeed);
+        SDL_SetAtomicInt(&cacheHitRate, (int)(population.getCacheHitRate() * 1000.0f));
+
+        if (evaluator)
+        {
+            evaluator->evaluate(population.getPopulation(), MultiSeedEvaluator::getSeeds(generationSeed, evaluationSeeds));
+        }
+        else
+        {
+            simulation.runEpisode(timeStep, maxEpisodeFrames, generationSeed);
+        }
+
+        population.storeFitness(generationSeed);
+
+        int fitness = population.getBestBird().getFitness();
+        if (fitness > SDL_GetAtomicInt(&bestFitness))
+            SDL_SetAtomicInt(&bestFitness, fitness);
+
+        if (migrationInterval > 0 && population.getGenerationNumber() % migrationInterval == 0)
+        {
+            if (outbox)
+                outbox->push(population.getBestBird());
+
+            Bird migrant = population.getBestBird();
+            while (inbox && inbox->pop(migrant))
+            {
+                population.immigrate(migrant);
+            }
+        }
+
+        population.evolveNewGeneration();
+        SDL_SetAtomicInt(&generation, population.getGenerationNumber());
+
+        if (maxGenerations > 0 && population.getGenerationNumber() > maxGenerations)
+            break;
+    }
+
+    std::string owner = "Island " + std::to_string(id);
+    (evaluator ? evaluator->getTerminationStats() : termination).log(owner.c_str());
+
+    SDL_SetAtomicInt(&running, 0);
 }
 
-float Bird::getYCordinate()
+bool Island::isRunning()
 {
-    return yCordinate;
+    return SDL_GetAtomicInt(&running) != 0;
 }
 
-float Bird::getXCordinate()
+int Island::getId()
 {
-    return xCordinate;
+    return id;
 }
 
-void Bird::incrementScore(int inc)
+int Island::getGeneration()
 {
-    score += inc;
+    return SDL_GetAtomicInt(&generation);
 }
 
-void Bird::setFitness(int value)
+int Island::getBestFitness()
 {
-    fitness = value;
+    return SDL_GetAtomicInt(&bestFitness);
 }
 
-int Bird::getScore()
+float Island::getCacheHitRate()
 {
-    return score;
+    return SDL_GetAtomicInt(&cacheHitRate) / 1000.0f;
 }
 
-// ----- Bird Class Decleration End -----
+// ----- Island Class Decleration End -----
 
-// ----- Pipe Class Decleration Start -----
+// ----- IslandModel Class Decleration Start -----
 
-Pipe::Pipe(float startingXCordinate, float groundHeight, float roofHeight, float windowHeight)
+IslandModel::IslandModel(const TrainingConfig &config) : config(config)
 {
-    width = 60;
-    gapHeight = 180;
-    Xspeed = 200;
-    Yspeed = 50;
-    xCordinate = startingXCordinate;
-    this->groundHeight = groundHeight;
-    this->roofHeight = roofHeight;
-    this->windowHeight = windowHeight;
+    unsigned int baseSeed = config.seed ? config.seed : static_cast<unsigned int>(time(NULL));
+
+    // Every island runs its own pools, so they split the cores instead of each claiming all of them
+    int cores = config.threads > 0 ? config.threads : SDL_GetNumLogicalCPUCores();
+    this->config.threads = std::max(1, cores / std::max(config.islands, 1));
 
-    goingDown = true;
+    // Every island numbers its own NEAT innovations, a migrant's genes would line up with unrelated ones
+    if (config.optimiser == "neat" && config.migrationInterval > 0)
+    {
+        SDL_Log("NEAT islands keep separate innovation tables, disabling migration");
+        this->config.migrationInterval = 0;
+    }
+
+    for (int i = 0; i < config.islands; ++i)
+    {
+        // The population is built here on the main thread, so it has to draw from the island's stream too
+        seedRandom(baseSeed + i * 7919u);
+        islands.push_back(std::make_unique<Island>(i, baseSeed + i * 7919u, this->config));
+    }
 
-    yCordinateGap = roofHeight + 10 + (gapHeight / 2) + (rand() % (int)(windowHeight - groundHeight - roofHeight - gapHeight - 20));
+    // Ring topology: island i sends its best genome to island i + 1
+    Bird prototype(10, {11, 11}, 1);
+    for (int i = 0; i < config.islands; ++i)
+    {
+        queues.push_back(std::make_unique<MigrationQueue>(4, prototype));
+    }
+    for (int i = 0; i < config.islands; ++i)
+    {
+        islands[i]->connect(queues[(i + config.islands - 1) % config.islands].get(), queues[i].get());
+    }
 }
 
-void Pipe::update(float deltaTime)
+void IslandModel::run()
 {
-    xCordinate -= Xspeed * deltaTime;
+    if (!SDL_Init(0))
+    {
+        SDL_Log("Unable to Initialized SDL: %s", SDL_GetError());
+        return;
+    }
 
-    if (goingDown)
-        yCordinateGap += Yspeed * deltaTime;
-    else
-        yCordinateGap -= Yspeed * deltaTime;
+    SDL_Log("Island model : %i islands x %i birds, migration every %i generations, %s optimiser, %i threads per island", config.islands, config.populationSize, config.migrationInterval, config.optimiser.c_str(), config.threads);
+
+    for (auto &island : islands)
+    {
+        island->start();
+    }
 
-    if (yCordinateGap + gapHeight / 2 + 10 >= windowHeight - groundHeight)
+    Uint64 lastReport = SDL_GetTicks();
+    bool anyRunning = true;
+    while (anyRunning)
     {
-        goingDown = !goingDown;
+        SDL_Delay(100);
+
+        anyRunning = false;
+        for (auto &island : islands)
+        {
+            if (island->isRunning())
+                anyRunning = true;
+        }
+
+        if (SDL_GetTicks() - lastReport < 1000 && anyRunning)
+            continue;
+        lastReport = SDL_GetTicks();
+
+        int globalBest = 0;
+        for (auto &island : islands)
+        {
+            SDL_Log("Island %i : GENERATION : %i : BEST FITNESS : %i : CACHE HIT RATE : %.1f%%", island->getId(), island->getGeneration(), island->getBestFitness(), island->getCacheHitRate() * 100.0f);
+            globalBest = std::max(globalBest, island->getBestFitness());
+        }
+        SDL_Log("Global : BEST FITNESS : %i", globalBest);
     }
-    if (yCordinateGap - gapHeight / 2 - 10 <= roofHeight)
+
+    for (auto &island : islands)
     {
-        goingDown = !goingDown;
+        island->join();
     }
+    SDL_Quit();
 }
 
-SDL_FRect Pipe::getTopRect()
-{
-    return {xCordinate, roofHeight, width, yCordinateGap - gapHeight / 2 - roofHeight};
-}
+// ----- IslandModel Class Decleration End -----
 
-SDL_FRect Pipe::getBottomRect()
-{
-    return {xCordinate, yCordinateGap + gapHeight / 2, width, windowHeight - (yCordinateGap + gapHeight / 2) - groundHeight};
-}
+// ----- WorkerPool Class Decleration Start -----
 
-bool Pipe::isOffScreen()
-{
-    return xCordinate + width < 0;
-}
+#define WORKER_MAGIC 0x59504C46 // "FLPY"
+#define WORKER_MAX_ATTEMPTS 3
 
-bool Pipe::hasPassedBird(float birdXCordinate)
+// A response is every bird's fitness, then every bird's behaviour descriptor
+struct EvaluationHeader
 {
-    return xCordinate + width < birdXCordinate;
-}
-
-float Pipe::getXCordinate()
+    Uint32 magic;
+    Uint32 count;
+    Uint32 genomeSize;
+    Uint32 seed; // First of the generation's seeds, see MultiSeedEvaluator::getSeeds
+    Uint32 seedCount;
+    Uint32 aggregation; // Index into WORKER_AGGREGATIONS
+    float quantile;
+    Uint32 maxEpisodeFrames;
+    Uint32 tickRate;
+};
+
+static const char *WORKER_AGGREGATIONS[] = {"mean", "min", "quantile"};
+
+static Uint32 getAggregationIndex(const std::string &aggregation)
 {
-    return xCordinate;
+    for (Uint32 i = 0; i < SDL_arraysize(WORKER_AGGREGATIONS); ++i)
+    {
+        if (aggregation == WORKER_AGGREGATIONS[i])
+            return i;
+    }
+    return 0;
 }
 
-float Pipe::getYcordinate()
+WorkerPool::WorkerPool(const TrainingConfig &config) : config(config), population(config), workers(config.workers), pool(1), restarts(0), genomesEvaluated(0)
 {
-    return yCordinateGap;
+    if (config.optimiser == "neat")
+    {
+        // NEAT topologies do not fit the flat genome blobs, so those generations stay in process
+        SDL_Log("NEAT genomes cannot be shipped to workers, evaluating in the coordinator");
+        workers.clear();
+    }
+
+    if (config.evaluationSeeds > 1)
+        evaluator = std::make_unique<MultiSeedEvaluator>(config, &pool, population.getOptimiser().getEliteCount());
 }
 
-float Pipe::getWidth()
+WorkerPool::~WorkerPool()
 {
-    return width;
+    for (auto &worker : workers)
+    {
+        retire(worker);
+    }
 }
 
-float Pipe::getGapHeight()
+bool WorkerPool::spawn(WorkerProcess &worker)
 {
-    return gapHeight;
+    const char *args[] = {config.executablePath.c_str(), "--worker", NULL};
+    worker.process = SDL_CreateProcess(args, true);
+    if (!worker.process)
+    {
+        SDL_Log("Unable to start worker process: %s", SDL_GetError());
+        return false;
+    }
+    return true;
 }
 
-// ----- Pipe Class Decleration End -----
-
-// ----- Population Class Decleration Start -----
-
-Population::Population(int size, float mRate)
+void WorkerPool::retire(WorkerProcess &worker)
 {
-    generationNumber = 1;
-    mutationRate = mRate;
-    populationSize = size;
-
-    for (int i = 0; i < populationSize; ++i)
+    if (worker.process)
     {
-        // population.push_back(Bird(10, {12, 12}, 1));
-        population.push_back(Bird(10, {11, 11}, 1));
+        SDL_KillProcess(worker.process, true);
+        SDL_WaitProcess(worker.process, true, NULL);
+        SDL_DestroyProcess(worker.process);
+        worker.process = nullptr;
     }
+    worker.batchStart = -1;
 }
 
-void Population::evolveNewGeneration()
+void WorkerPool::evaluateGeneration(unsigned int seed)
 {
-    int elitism = 0;
-    std::vector<int> topElitism(3, 0);
-    for (int i = 0; i < populationSize; ++i)
+    std::vector<Bird> &birds = population.getPopulation();
+    int genomeSize = birds[0].getGenomeSize();
+    int batchSize = config.batchSize > 0 ? config.batchSize : ((int)birds.size() + config.workers - 1) / config.workers;
+    int batchCount = ((int)birds.size() + batchSize - 1) / batchSize;
+
+    std::vector<int> pending;
+    std::vector<int> attempts(batchCount, 0);
+    for (int batch = batchCount - 1; batch >= 0; --batch)
     {
-        if (population[i].getFitness() > population[topElitism[0]].getFitness())
-        {
-            topElitism[2] = topElitism[1];
-            topElitism[1] = topElitism[0];
-            topElitism[0] = i;
-        }
-        else if (population[i].getFitness() > population[topElitism[1]].getFitness())
+        pending.push_back(batch);
+    }
+
+    int remaining = batchCount;
+    while (remaining > 0)
+    {
+        bool progressed = false;
+        int available = 0;
+
+        for (auto &worker : workers)
         {
-            topElitism[2] = topElitism[1];
-            topElitism[1] = i;
+            if (!worker.process && !spawn(worker))
+                continue;
+            ++available;
+
+            if (worker.batchStart < 0)
+            {
+                if (pending.empty())
+                    continue;
+
+                int batch = pending.back();
+                pending.pop_back();
+                ++attempts[batch];
+
+                worker.batchStart = batch * batchSize;
+                worker.batchCount = std::min(batchSize, (int)birds.size() - worker.batchStart);
+
+                EvaluationHeader header = {WORKER_MAGIC, (Uint32)worker.batchCount, (Uint32)genomeSize, seed, (Uint32)std::max(config.evaluationSeeds, 1), getAggregationIndex(config.aggregation), config.quantile, (Uint32)config.maxEpisodeFrames, (Uint32)std::max(config.tickRate, 1)};
+                worker.request.resize(sizeof(header) + sizeof(float) * genomeSize * worker.batchCount);
+                SDL_memcpy(worker.request.data(), &header, sizeof(header));
+                for (int i = 0; i < worker.batchCount; ++i)
+                {
+                    std::vector<float> genome = birds[worker.batchStart + i].getGenome();
+                    SDL_memcpy(worker.request.data() + sizeof(header) + sizeof(float) * genomeSize * i, genome.data(), sizeof(float) * genomeSize);
+                }
+                worker.sent = 0;
+                worker.response.resize((sizeof(Sint32) + sizeof(float) * BEHAVIOUR_SAMPLES) * worker.batchCount);
+                worker.received = 0;
+            }
+
+            // Process pipes are non-blocking, so every worker is pumped a little per pass
+            if (worker.sent < worker.request.size())
+            {
+                size_t written = SDL_WriteIO(SDL_GetProcessInput(worker.process), worker.request.data() + worker.sent, worker.request.size() - worker.sent);
+                worker.sent += written;
+                progressed |= written > 0;
+            }
+            if (worker.received < worker.response.size())
+            {
+                size_t read = SDL_ReadIO(SDL_GetProcessOutput(worker.process), worker.response.data() + worker.received, worker.response.size() - worker.received);
+                worker.received += read;
+                progressed |= read > 0;
+            }
+
+            if (worker.received == worker.response.size())
+            {
+                const Sint32 *fitness = reinterpret_cast<const Sint32 *>(worker.response.data());
+                const float *samples = reinterpret_cast<const float *>(fitness + worker.batchCount);
+                for (int i = 0; i < worker.batchCount; ++i)
+                {
+                    birds[worker.batchStart + i].setFitness(fitness[i]);
+                    birds[worker.batchStart + i].setBehaviour(std::vector<float>(samples + i * BEHAVIOUR_SAMPLES, samples + (i + 1) * BEHAVIOUR_SAMPLES));
+                }
+                genomesEvaluated += worker.batchCount;
+                worker.batchStart = -1;
+                --remaining;
+                progressed = true;
+                continue;
+            }
+
+            int exitCode = 0;
+            if (SDL_WaitProcess(worker.process, false, &exitCode))
+            {
+                int batch = worker.batchStart / batchSize;
+                SDL_Log("Worker died mid-batch (exit code %i), %i genomes requeued", exitCode, worker.batchCount);
+                retire(worker);
+                ++restarts;
+
+                if (attempts[batch] < WORKER_MAX_ATTEMPTS)
+                {
+                    pending.push_back(batch);
+                }
+                else
+                {
+                    // A batch that keeps crashing its worker is scored as a failure
+                    int start = batch * batchSize;
+                    for (int i = start; i < std::min(start + batchSize, (int)birds.size()); ++i)
+                    {
+                        birds[i].setFitness(0);
+                    }
+                    --remaining;
+                }
+                progressed = true;
+            }
         }
-        else if (population[i].getFitness() > population[topElitism[2]].getFitness())
+
+        if (available == 0)
         {
-            topElitism[2] = i;
+            // No worker can be started, so evaluate what is left in this process
+            if (evaluator)
+            {
+                evaluator->evaluate(birds, MultiSeedEvaluator::getSeeds(seed, config.evaluationSeeds));
+            }
+            else
+            {
+                BirdStates states;
+                Simulation simulation(birds, states, 800, 600, 5, 5);
+                simulation.runEpisode(1.0f / std::max(config.tickRate, 1), config.maxEpisodeFrames, seed);
+            }
+            genomesEvaluated += birds.size();
+            return;
         }
-    }
-
-    std::vector<Bird> newGeneration;
-    newGeneration.reserve(populationSize);
-
-    int start = 0;
 
-    Bird elite1 = population[topElitism[0]];
-    elite1.reset();
-    newGeneration.push_back(elite1);
-    ++start;
+        if (!progressed)
+            SDL_Delay(1);
+    }
+}
 
-    for (; start < populationSize / 3; ++start)
+void WorkerPool::run()
+{
+    if (!SDL_Init(0))
     {
-        Bird child = elite1;
-        child.mutate(mutationRate);
-        newGeneration.push_back(child);
+        SDL_Log("Unable to Initialized SDL: %s", SDL_GetError());
+        return;
     }
 
-    Bird elite2 = population[topElitism[1]];
-    elite2.reset();
-    newGeneration.push_back(elite2);
-    ++start;
+    SDL_Log("Coordinator : %i worker processes, %i birds per generation, %s optimiser", config.workers, config.populationSize, population.getOptimiser().getName());
 
-    for (; start < (populationSize / 3) * 2; ++start)
+    Uint64 trainingStart = SDL_GetTicks();
+
+    while (config.maxGenerations == 0 || population.getGenerationNumber() <= config.maxGenerations)
     {
-        Bird child = elite2;
-        child.mutate(mutationRate);
-        newGeneration.push_back(child);
+        // Every batch of a generation flies through the same pipes
+        unsigned int seed = config.evaluationSeed ? config.evaluationSeed : (unsigned int)randomInt(0x7FFFFFFF);
+
+        Uint64 generationStart = SDL_GetTicks();
+        population.applyFitnessCache(seed);
+        evaluateGeneration(seed);
+        population.storeFitness(seed);
+        Uint64 generationTime = std::max<Uint64>(SDL_GetTicks() - generationStart, 1);
+        Uint64 totalTime = std::max<Uint64>(SDL_GetTicks() - trainingStart, 1);
+
+        SDL_Log("Coordinator : GENERATION : %i : BEST FITNESS : %i : GENOMES/SEC : %.1f (overall %.1f) : WORKER RESTARTS : %i : CACHE HIT RATE : %.1f%%",
+                population.getGenerationNumber(), population.getBestBird().getFitness(),
+                config.populationSize * 1000.0 / generationTime, genomesEvaluated * 1000.0 / totalTime, restarts,
+                population.getCacheHitRate() * 100.0f);
+
+        population.evolveNewGeneration();
     }
 
-    Bird elite3 = population[topElitism[2]];
-    elite3.reset();
-    newGeneration.push_back(elite3);
-    ++start;
-
-    for (; start < populationSize; ++start)
+    for (auto &worker : workers)
     {
-        Bird child = elite3;
-        child.mutate(mutationRate);
-        newGeneration.push_back(child);
+        retire(worker);
     }
-
-    population = newGeneration;
-    ++generationNumber;
+    SDL_Quit();
 }
 
-std::vector<Bird> &Population::getPopulation()
+int runEvaluationWorker()
 {
-    return population;
-}
+    Bird prototype(10, {11, 11}, 1);
+    std::vector<float> blob;
+    std::vector<float> genome(prototype.getGenomeSize());
+    EvaluationHeader header;
+    ThreadPool pool(1); // The coordinator runs one worker per core already
+
+    // Runs until the coordinator closes our stdin or kills us
+    while (fread(&header, sizeof(header), 1, stdin) == 1)
+    {
+        if (header.magic != WORKER_MAGIC || (int)header.genomeSize != prototype.getGenomeSize())
+            return 1;
 
-int Population::getGenerationNumber()
-{
-    return generationNumber;
+        blob.resize((size_t)header.count * header.genomeSize);
+        if (fread(blob.data(), sizeof(float), blob.size(), stdin) != blob.size())
+            return 1;
+
+        std::vector<Bird> birds(header.count, prototype);
+        for (Uint32 i = 0; i < header.count; ++i)
+        {
+            genome.assign(blob.begin() + i * header.genomeSize, blob.begin() + (i + 1) * header.genomeSize);
+            birds[i].setGenome(genome);
+        }
+
+        std::vector<Sint32> fitness(header.count, 0);
+        std::vector<float> samples((size_t)header.count * BEHAVIOUR_SAMPLES, 0.0f);
+        if (header.count > 0 && header.seedCount > 1)
+        {
+            // A batch is a slice of the generation, so no bird here knows the elite set to prune against
+            TrainingConfig evaluation;
+            evaluation.evaluationSeeds = (int)header.seedCount;
+            evaluation.aggregation = WORKER_AGGREGATIONS[std::min<Uint32>(header.aggregation, SDL_arraysize(WORKER_AGGREGATIONS) - 1)];
+            evaluation.quantile = header.quantile;
+            evaluation.maxEpisodeFrames = (int)header.maxEpisodeFrames;
+            evaluation.tickRate = (int)header.tickRate;
+
+            MultiSeedEvaluator evaluator(evaluation, &pool);
+            evaluator.evaluate(birds, MultiSeedEvaluator::getSeeds(header.seed, evaluation.evaluationSeeds));
+        }
+        else if (header.count > 0)
+        {
+            BirdStates states;
+            Simulation simulation(birds, states, 800, 600, 5, 5);
+            simulation.runEpisode(1.0f / std::max<Uint32>(header.tickRate, 1), header.maxEpisodeFrames, header.seed);
+        }
+
+        for (Uint32 i = 0; i < header.count; ++i)
+        {
+            fitness[i] = birds[i].getFitness();
+            std::vector<float> descriptor = birds[i].getBehaviour();
+            std::copy(descriptor.begin(), descriptor.end(), samples.begin() + i * BEHAVIOUR_SAMPLES);
+        }
+
+        fwrite(fitness.data(), sizeof(Sint32), fitness.size(), stdout);
+        fwrite(samples.data(), sizeof(float), samples.size(), stdout);
+        fflush(stdout);
+    }
+
+    return 0;
 }
 
-// ----- Population Class Decleration End -----
+// ----- WorkerPool Class Decleration End -----
 
 // ----- Game Class Decleration Start -----
 
-Game::Game() : populationSize(15), mutationRate(0.05f), population(populationSize, mutationRate)
+Game::Game(const TrainingConfig &config) : window(nullptr), renderer(nullptr), windowWidth(800), windowHeight(600), roofHeight(5), groundHeight(5), populationSize(config.populationSize), mutationRate(config.mutationRate), steadyState(config.steadyState), headless(config.headless), maxGenerations(config.maxGenerations), timeStep(1.0f / std::max(config.tickRate, 1)), population(config), simulation(population.getPopulation(), population.getStates(), windowWidth, windowHeight, roofHeight, groundHeight), pool(config.threads), evaluationSeeds(config.evaluationSeeds), evaluationSeed(config.evaluationSeed)
 {
-    srand(static_cast<unsigned int>(time(NULL)));
+    simulation.configureTermination(config, &termination);
+    simulation.setThreadPool(&pool);
+    simulation.getEnvironment().setTimeStep(timeStep);
+    population.getOptimiser().setThreadPool(&pool);
+
+    // The constructor already drew pipes, a fixed seed replaces them
+    if (evaluationSeed)
+        simulation.reset(evaluationSeed);
 
-    survivalFrames = 0;
-    windowHeight = 600;
-    windowWidth = 800;
-    groundHeight = 5;
-    roofHeight = 5;
-    pipeSpawnTimer = 0;
-    PipeSpawnInterval = 2.8f;
+    // parseArguments only lets several seeds through for headless generations
+    if (evaluationSeeds > 1)
+        evaluator = std::make_unique<MultiSeedEvaluator>(config, &pool, population.getOptimiser().getEliteCount());
 
-    pipes.push_back({Pipe(800, groundHeight, roofHeight, windowHeight)});
+    if (headless)
+    {
+        // No video subsystem at all, so this runs on machines without a display
+        if (!SDL_Init(0))
+            SDL_Log("Unable to Initialized SDL: %s", SDL_GetError());
+        return;
+    }
 
     if (!SDL_Init(SDL_INIT_VIDEO))
     {
@@ -516,10 +4778,7 @@ Game::Game() : populationSize(15), mutationRate(0.05f), population(populationSiz
 
 void Game::resetGame()
 {
-    pipes.clear();
-    pipes.push_back({Pipe(800, groundHeight, roofHeight, windowHeight)});
-    pipeSpawnTimer = 0;
-    survivalFrames = 0;
+    simulation.reset(evaluationSeed ? evaluationSeed : (unsigned int)randomInt(0x7FFFFFFF));
 }
 
 void Game::run()
@@ -527,8 +4786,18 @@ void Game::run()
     bool running = true;
 
     Uint64 lastTickCheck = SDL_GetTicks();
-    float deltaTime = 0.0f;
+    float accumulator = 0.0f;
+
+    Uint64 lastReport = lastTickCheck;
+    int lastBirths = 0;
+    int lastInsertions = 0;
 
+    Uint64 lastSpeedReport = lastTickCheck;
+    long long simulationSteps = 0;
+    int lastGeneration = population.getGenerationNumber();
+    int lastSpeedBirths = 0;
+
+    std::vector<std::vector<double>> rayCollection;
     SDL_Event event;
 
     while (running)
@@ -536,12 +4805,17 @@ void Game::run()
         try
         {
             Uint64 currentTickCheck = SDL_GetTicks();
-            deltaTime = (float)(currentTickCheck - lastTickCheck) / 1000.0f;
+            float frameTime = (float)(currentTickCheck - lastTickCheck) / 1000.0f;
             lastTickCheck = currentTickCheck;
 
-            ++survivalFrames;
+            // Wall-clock time only decides how many fixed steps run, never how long a step is.
+            // Nothing is shown headless, so there is no clock to follow and one step runs per iteration
+            if (headless)
+                accumulator = timeStep;
+            else
+                accumulator += std::min(frameTime, MAX_FRAME_TIME);
 
-            while (SDL_PollEvent(&event))
+            while (!headless && SDL_PollEvent(&event))
             {
                 if (event.type == SDL_EVENT_QUIT)
                 {
@@ -557,97 +4831,100 @@ void Game::run()
                 }
             }
 
-            pipeSpawnTimer += deltaTime;
-            if (pipeSpawnTimer > PipeSpawnInterval)
-            {
-                pipes.push_back({Pipe(800, groundHeight, roofHeight, windowHeight)});
-                pipeSpawnTimer = 0;
-            }
-
-            Pipe *nearest = nullptr;
-
-            for (auto &pipe : pipes)
+            while (running && accumulator >= timeStep)
             {
-                pipe.update(deltaTime);
+                accumulator -= timeStep;
 
-                if (nearest == nullptr && pipe.getXCordinate() + pipe.getWidth() > population.getPopulation()[0].getXCordinate())
+                if (evaluator)
                 {
-                    nearest = &pipe;
-                }
-            }
-
-            bool foundAliveBird = false;
-
-            std::vector<std::vector<double>> rayCollection;
-
-            for (int i = 0; i < populationSize; ++i)
-            {
-                Bird &bird = population.getPopulation()[i];
-
-                if (bird.getGameOver())
+                    // One pass flies the whole generation on every seed, there is no shared flock to step
+                    unsigned int generationSeed = evaluationSeed ? evaluationSeed : (unsigned int)randomInt(0x7FFFFFFF);
+                    population.applyFitnessCache(generationSeed);
+                    evaluator->evaluate(population.getPopulation(), MultiSeedEvaluator::getSeeds(generationSeed, evaluationSeeds));
+                    population.storeFitness(generationSeed);
+                    simulationSteps += evaluator->getSteps();
+
+                    population.evolveNewGeneration();
+                    if (maxGenerations > 0 && population.getGenerationNumber() > maxGenerations)
+                        running = false;
                     continue;
-
-                Ray ray[RAYS_NUMBER];
-                generate_rays(bird, ray, nearest);
-
-                std::vector<float> input(RAYS_NUMBER);
-                for (int r = 0; r < RAYS_NUMBER; ++r)
-                {
-                    rayCollection.push_back({ray[r].startX, ray[r].startY, ray[r].endX, ray[r].endY});
-                    input[r] = sqrt(pow(ray[r].endX - ray[r].startX, 2) + pow(ray[r].endY - ray[r].startY, 2));
                 }
 
-                if (bird.feedForward(input)[0] > 0.5f)
-                {
-                    bird.flap();
-                }
+                rayCollection.clear();
+                if (steadyState)
+                    simulation.setEliteThreshold(population.getEliteThreshold());
+                bool foundAliveBird = simulation.step(timeStep, headless ? nullptr : &rayCollection);
+                ++simulationSteps;
 
-                if (bird.getYCordinate() > windowHeight - groundHeight || bird.getYCordinate() < roofHeight)
+                if (steadyState)
                 {
-                    bird.setGameOver(true);
-                }
+                    // No generation barrier : every dead bird is replaced by an offspring of the archive
+                    population.refillDeadBirds();
 
-                bird.update(deltaTime);
-
-                SDL_FRect birdRect = bird.getRect();
-                SDL_FRect topPipe = nearest->getTopRect();
-                SDL_FRect bottomPipe = nearest->getBottomRect();
-
-                if (SDL_HasRectIntersectionFloat(&birdRect, &topPipe) || SDL_HasRectIntersectionFloat(&birdRect, &bottomPipe))
-                {
-                    bird.setGameOver(true);
+                    // The generation counter never moves, so a population's worth of births stands in for one
+                    if (headless && maxGenerations > 0 && population.getBirths() >= (long long)maxGenerations * populationSize)
+                        running = false;
                 }
-
-                if (nearest->hasPassedBird(bird.getXCordinate()))
+                else if (!foundAliveBird)
                 {
-                    bird.incrementScore(1);
+                    // Fitness is cached under the pipes just flown, so it is stored before the reset draws new ones
+                    population.storeFitness(simulation.getSeed());
+                    resetGame();
+                    population.evolveNewGeneration();
+                    population.applyFitnessCache(simulation.getSeed());
+                    if (!headless)
+                        SDL_Log("Evolving Population : GENERATION : %i", population.getGenerationNumber());
+
+                    if (headless && maxGenerations > 0 && population.getGenerationNumber() > maxGenerations)
+                        running = false;
                 }
-
-                bird.setFitness(bird.getScore() * 10 + survivalFrames);
-
-                if (bird.getGameOver() == false)
-                    foundAliveBird = true;
             }
 
-            pipes.erase(remove_if(pipes.begin(), pipes.end(), [](Pipe &pipe)
-                                  { return pipe.isOffScreen(); }),
-                        pipes.end());
+            if (!headless)
+            {
+                // Rendering Part Start
+                // The leftover fraction of a step places everything between the last two physics states
+                float alpha = accumulator / timeStep;
+                renderBackground();
+                renderRays(rayCollection);
+                renderPipes(alpha);
+                renderRoof();
+                renderGround();
+                renderBirds(alpha);
+                SDL_RenderPresent(renderer);
+                // Rendering Part End
+            }
 
-            // Rendering Part Start
-            renderBackground();
-            renderRays(rayCollection);
-            renderPipes();
-            renderRoof();
-            renderGround();
-            renderBirds();
-            SDL_RenderPresent(renderer);
-            // Rendering Part End
+            if (steadyState && currentTickCheck - lastReport >= 1000)
+            {
+                float seconds = (currentTickCheck - lastReport) / 1000.0f;
+                EliteArchive &archive = population.getArchive();
+                SDL_Log("Steady State : BIRTHS/SEC : %.1f : ARCHIVE TURNOVER : %.1f%%/s : BEST ARCHIVED FITNESS : %i",
+                        (population.getBirths() - lastBirths) / seconds,
+                        100.0f * (archive.getInsertions() - lastInsertions) / (std::max(archive.getSize(), 1) * seconds),
+                        archive.getBestFitness());
+
+                lastReport = currentTickCheck;
+                lastBirths = population.getBirths();
+                lastInsertions = archive.getInsertions();
+            }
 
-            if (!foundAliveBird)
+            if (headless && (currentTickCheck - lastSpeedReport >= 1000 || !running))
             {
-                resetGame();
-                population.evolveNewGeneration();
-                SDL_Log("Evolving Population : GENERATION : %i", population.getGenerationNumber());
+                float seconds = std::max<Uint64>(currentTickCheck - lastSpeedReport, 1) / 1000.0f;
+                if (steadyState)
+                    SDL_Log("Headless : BIRTHS : %i : BIRTHS/SEC : %.0f : SIM STEPS/SEC : %.0f : ALIVE : %i : THREADS : %i",
+                            population.getBirths(), (population.getBirths() - lastSpeedBirths) / seconds,
+                            simulationSteps / seconds, simulation.getStepStats().aliveBirds, pool.getThreadCount());
+                else
+                    SDL_Log("Headless : GENERATION : %i : GENS/SEC : %.2f : SIM STEPS/SEC : %.0f : ALIVE : %i : THREADS : %i : CACHE HIT RATE : %.1f%%",
+                            population.getGenerationNumber(), (population.getGenerationNumber() - lastGeneration) / seconds,
+                            simulationSteps / seconds, simulation.getStepStats().aliveBirds, pool.getThreadCount(), population.getCacheHitRate() * 100.0f);
+
+                lastSpeedReport = currentTickCheck;
+                lastGeneration = population.getGenerationNumber();
+                lastSpeedBirths = population.getBirths();
+                simulationSteps = 0;
             }
         }
         catch (...)
@@ -656,8 +4933,11 @@ void Game::run()
             SDL_Delay(100);
         }
 
-        SDL_Delay(17); // ~60FPS
+        if (!headless)
+            SDL_Delay(17); // ~60FPS
     }
+
+    (evaluator ? evaluator->getTerminationStats() : termination).log("Game");
 }
 
 void Game::renderBackground()
@@ -673,15 +4953,17 @@ void Game::renderBackground()
     SDL_DestroyTexture(back);
 }
 
-void Game::renderPipes()
+void Game::renderPipes(float alpha)
 {
     SDL_Texture *pipeT = IMG_LoadTexture(renderer, "./Resources/Image/Top_Pipe.png");
     SDL_Texture *pipeB = IMG_LoadTexture(renderer, "./Resources/Image/Bottom_Pipe.png");
 
-    for (auto &pipe : pipes)
+    FlappyEnv &environment = simulation.getEnvironment();
+    for (int k = 0; k < environment.getPipeCount(0); ++k)
     {
-        SDL_FRect topPipe = pipe.getTopRect();
-        SDL_FRect bottomPipe = pipe.getBottomRect();
+        PipeView pipe = environment.getPipeView(0, k, alpha);
+        SDL_FRect topPipe = pipe.top;
+        SDL_FRect bottomPipe = pipe.bottom;
 
         SDL_RenderTexture(renderer, pipeT, NULL, &topPipe);
         SDL_RenderTexture(renderer, pipeB, NULL, &bottomPipe);
@@ -703,44 +4985,34 @@ void Game::renderRays(std::vector<std::vector<double>> rayCollection)
     }
 }
 
-void Game::renderBirds()
+void Game::renderBirds(float alpha)
 {
-    int i = 0;
-    SDL_Texture *bird1 = IMG_LoadTexture(renderer, "./Resources/Image/Bird_1.png");
-    for (; i < populationSize / 3; ++i)
-    {
-        Bird &bird = population.getPopulation()[i];
-        if (bird.getGameOver())
-            continue;
+    BirdStates &states = population.getStates();
+    int birdCount = std::min(populationSize, states.size());
 
-        SDL_FRect birdBody = bird.getRect();
-        SDL_RenderTexture(renderer, bird1, NULL, &birdBody);
-    }
-    SDL_DestroyTexture(bird1);
+    // Each third of the flock has its own sprite
+    SDL_Texture *sprites[3] = {IMG_LoadTexture(renderer, "./Resources/Image/Bird_1.png"),
+                               IMG_LoadTexture(renderer, "./Resources/Image/Bird_2.png"),
+                               IMG_LoadTexture(renderer, "./Resources/Image/Bird_3.png")};
 
-    SDL_Texture *bird2 = IMG_LoadTexture(renderer, "./Resources/Image/Bird_2.png");
-    for (; i < populationSize * 2 / 3; ++i)
+    for (int word : states.liveWords)
     {
-        Bird &bird = population.getPopulation()[i];
-        if (bird.getGameOver())
-            continue;
+        for (Uint64 bits = states.alive[word]; bits; bits &= bits - 1)
+        {
+            int i = word * 64 + lowestSetBit(bits);
+            if (i >= birdCount)
+                break;
 
-        SDL_FRect birdBody = bird.getRect();
-        SDL_RenderTexture(renderer, bird2, NULL, &birdBody);
+            SDL_FRect birdBody = states.getInterpolatedRect(i, alpha);
+            int sprite = i < birdCount / 3 ? 0 : (i < birdCount * 2 / 3 ? 1 : 2);
+            SDL_RenderTexture(renderer, sprites[sprite], NULL, &birdBody);
+        }
     }
-    SDL_DestroyTexture(bird2);
 
-    SDL_Texture *bird3 = IMG_LoadTexture(renderer, "./Resources/Image/Bird_3.png");
-    for (; i < populationSize; ++i)
+    for (auto sprite : sprites)
     {
-        Bird &bird = population.getPopulation()[i];
-        if (bird.getGameOver())
-            continue;
-
-        SDL_FRect birdBody = bird.getRect();
-        SDL_RenderTexture(renderer, bird3, NULL, &birdBody);
+        SDL_DestroyTexture(sprite);
     }
-    SDL_DestroyTexture(bird3);
 }
 
 void Game::renderRoof()
@@ -3,49 +3,205 @@
 
 #include <SDL3/SDL.h>
 #include <SDL3_image/SDL_image.h>
+#include <SDL3/SDL_intrin.h>
 #include <vector>
 #include <cstdlib> // srand
 #include <cmath>
 #include <algorithm>
 #include <ctime> // time
+#include <random>
+#include <memory>
+#include <string>
+#include <map>
+#include <unordered_map>
+#include <functional>
 
-class Bird
+// Every thread owns its own random stream so islands evolve independently
+void seedRandom(unsigned int seed);
+float randomUniform();
+int randomInt(int upperBound);
+float randomGaussian();
+
+struct TrainingConfig
+{
+    int populationSize = 15;
+    float mutationRate = 0.05f;
+
+    int islands = 0; // 0 runs the windowed game
+    bool headless = false; // Run the game loop without window, rendering or frame delay
+    int tickRate = 60; // Fixed physics steps per simulated second, of the game loop and of every evaluator
+    int migrationInterval = 10;
+    int maxGenerations = 0; // 0 trains until stopped, steady state counts a population's worth of births as one
+    int maxEpisodeFrames = 0; // Stop birds alive this many steps of the tick rate, 0 disables; parseArguments caps runs without a window at 3600
+    unsigned int seed = 0; // 0 seeds from the clock
+
+    bool steadyState = false; // Refill dead birds at once instead of waiting for the generation to end
+    int archiveSize = 10;
+
+    int workers = 0; // > 0 evaluates generations in worker processes
+    int batchSize = 0; // 0 splits each generation evenly across workers
+    bool worker = false; // Set on the processes spawned by the coordinator
+    std::string executablePath;
+
+    std::string optimiser = "elitist"; // elitist, openai-es, sep-cma-es, neat or species
+    float sigma = 0.5f; // Initial search radius of the ES optimisers
+    float learningRate = 0.03f; // OpenAI-ES step size
+
+    int evaluationSeeds = 1; // Pipe sequences each genome is scored on
+    std::string aggregation = "mean"; // mean, min or quantile
+    float quantile = 0.25f;
+    int threads = 0; // 0 uses every logical core
+
+    bool novelty = false; // Select on behavioural novelty instead of fitness
+    int noveltyNeighbours = 15;
+    float noveltyArchiveRate = 0.1f; // Chance of a behaviour entering the archive
+
+    unsigned int evaluationSeed = 0; // 0 draws new pipes every generation
+    bool fitnessCache = false; // Reuse fitness of genomes already flown on the same seed
+
+    float noProgressSeconds = 0.0f; // Stop birds that pass no pipe for this long, 0 disables
+    bool dominanceCutoff = false; // Stop birds that provably cannot reach the elite set
+
+    bool deltaGenomes = false; // Store mutations as sparse deltas over the parent's blocks
+
+    int species = 8; // k-means clusters of the species optimiser
+
+    bool diversity = false; // Log genome diversity every generation
+
+    float surrogateFraction = 0.0f; // > 0 simulates only this top fraction of a surrogate-ranked candidate pool
+};
+
+class NeatNetwork;
+class ThreadPool;
+
+#define GENOME_BLOCK_SIZE 16 // Floats per block, one cache line
+
+class GenomeArena;
+
+struct GenomeBlock
+{
+    SDL_AtomicInt references;
+    GenomeArena *arena; // nullptr when the block came from the heap
+    float values[GENOME_BLOCK_SIZE];
+};
+
+// Bump allocator for the blocks of one generation. Blocks are never freed one by one,
+// the whole arena is rewound once none of them is referenced any more
+class GenomeArena
 {
 private:
-    float xCordinate;
-    float yCordinate;
+    std::vector<char *> chunks;
+    int chunkIndex;
+    size_t chunkUsed;
+
+    // One reference per live block plus one for the owner, the last release deletes the arena
+    SDL_AtomicInt references;
 
+public:
+    GenomeArena();
+    ~GenomeArena();
+
+    GenomeBlock *allocate();
+    void release();
+
+    // True when the owner holds the only reference, so no block can still be read
+    bool isIdle();
+    void reset();
+    size_t getReservedBytes();
+
+    // Blocks allocated on this thread come from the given arena, nullptr for the heap
+    static GenomeArena *use(GenomeArena *arena);
+};
+
+// Flat parameter vector held as reference-counted blocks. Copies share every block,
+// and a write only duplicates the block it lands in while that block is still shared
+class Genome
+{
+private:
+    std::vector<GenomeBlock *> blocks;
     int size;
 
-    float velocity;
-    float gravity;
-    float jumpStrength;
+    // Sparse (index, delta) pairs sorted by index, added on top of the block values
+    std::vector<std::pair<int, float>> deltas;
+
+    static GenomeBlock *allocateBlock();
+    static void releaseBlock(GenomeBlock *block);
+
+    float &writeStored(int index);
+
+public:
+    Genome();
+    Genome(int size);
+    Genome(const Genome &other);
+    Genome(Genome &&other) noexcept;
+    Genome &operator=(const Genome &other);
+    Genome &operator=(Genome &&other) noexcept;
+    ~Genome();
+
+    int getSize() const;
+    float get(int index) const;
+    // Block value without the deltas, for readers that walk the deltas themselves
+    float getStored(int index) const;
+    // Copies the enclosing block first if another genome still shares it
+    float &at(int index);
+
+    void addDelta(int index, float delta);
+    const std::vector<std::pair<int, float>> &getDeltas() const;
+    // Folds the deltas into private copies of the blocks they touch
+    void materialise();
+
+    // Copies every block living elsewhere into the arena, moved keeps shared blocks shared
+    void relocate(GenomeArena *arena, std::unordered_map<GenomeBlock *, GenomeBlock *> &moved);
 
+    int getBlockCount() const;
+    int getSharedBlockCount() const;
+};
+
+class Bird
+{
+private:
+    // Results of the last flight, written back by the simulation when the bird stops.
+    // The state that changes every step lives in BirdStates
+    float yCordinate;
     int score;
     int fitness;
+    int framesAlive;
     bool gameOver;
+    bool deltaEncoded; // Mutations go to the genome's delta list instead of its blocks
+
+    std::vector<float> behaviour; // Sampled heights, the novelty search descriptor
 
     int i_nodes;
     std::vector<int> h_nodes;
     int o_nodes;
 
-    std::vector<std::vector<std::vector<float>>> weights_hh;
-    std::vector<std::vector<float>> weights_ho;
-    std::vector<std::vector<float>> bias_h;
-    std::vector<float> bias_o;
+    // Flat layout : hidden weights layer by layer, output weights, hidden biases, output biases
+    Genome genome;
+
+    // When set, replaces the fixed dense layers above
+    std::shared_ptr<const NeatNetwork> network;
 
 public:
     Bird(int inputNodes, std::vector<int> hiddenNodes, int outputNodes);
 
-    void flap();
-    void update(float deltaTime);
     void reset();
-
-    SDL_FRect getRect();
+    void recordFlight(float yCordinate, int score, int fitness, int framesAlive, bool gameOver);
+    void sampleBehaviour(float height);
 
     std::vector<float> feedForward(const std::vector<float> &inputs);
     void mutate(float mutationRate);
 
+    int getGenomeSize();
+    // Weights per layer in flat order, hidden layers first then the output layer
+    std::vector<int> getWeightLayerSizes();
+    std::vector<float> getGenome();
+    void setGenome(const std::vector<float> &genome);
+    Uint64 getGenomeHash();
+    std::shared_ptr<const NeatNetwork> getNetwork();
+    void setNetwork(std::shared_ptr<const NeatNetwork> network);
+    void setDeltaEncoded(bool enabled);
+    void relocateGenome(GenomeArena *arena, std::unordered_map<GenomeBlock *, GenomeBlock *> &moved);
+
     float sigmoid(float x);
     float randomFloat();
     float randomChance();
@@ -55,56 +211,878 @@ public:
     bool getGameOver();
     void setGameOver(bool condition);
     float getYCordinate();
-    float getXCordinate();
-    void incrementScore(int inc);
     int getScore();
+    int getFramesAlive();
+    std::vector<float> getBehaviour();
+    void setBehaviour(const std::vector<float> &descriptor);
 };
 
-class Pipe
+// Hot per-bird simulation state as a structure of arrays, indexed by the bird's slot in the flock.
+// Physics and collision stream these arrays, the genome and flight results stay in Bird
+struct BirdStates
+{
+    std::vector<float> y;
+    std::vector<float> previousY; // Height before the last step, for render interpolation
+    std::vector<float> velocity;
+    std::vector<Uint64> alive; // One bit per slot
+    std::vector<int> score;
+    std::vector<int> fitness;
+    std::vector<int> framesAlive;
+
+    // Words of the alive bitset that still have a bit set, so dead stretches of the flock are never visited
+    std::vector<int> liveWords;
+    int aliveCount;
+
+    // Resizes to count slots, all of them flying from the start position
+    void reset(int count);
+    // Puts one slot back at the start position, reviving it if it had stopped
+    void resetSlot(int slot);
+    // Drops emptied words from liveWords and recounts, after bits were cleared straight in alive
+    void compact();
+
+    int size() const;
+    bool isAlive(int slot) const;
+
+    SDL_FRect getRect(int slot) const;
+    // Blends the last two physics states, alpha 0 is the previous state and 1 the current one
+    SDL_FRect getInterpolatedRect(int slot, float alpha) const;
+};
+
+// The pipe a bird looks at and collides with, however the pipe itself is stored
+struct PipeView
 {
-private:
     float xCordinate;
     float width;
-    float gapHeight;
     float yCordinateGap;
-    float Xspeed;
-    float Yspeed;
-    float windowHeight;
-    float roofHeight;
-    float groundHeight;
+    float gapHeight;
+    SDL_FRect top;
+    SDL_FRect bottom;
+};
 
-    bool goingDown;
+class EliteArchive
+{
+private:
+    // Best birds seen so far, sorted by descending fitness
+    std::vector<Bird> elites;
+    int capacity;
+    int insertions;
 
 public:
-    Pipe(float startingXCordinate, float groundHeight, float roofHeight, float windowHeight);
+    EliteArchive(int capacity);
 
-    void update(float deltaTime);
+    bool offer(const Bird &bird);
+    Bird &select();
 
-    SDL_FRect getTopRect();
-    SDL_FRect getBottomRect();
+    int getBestFitness();
+    // Fitness a bird must beat to enter the full archive, 0 while there is still room
+    int getEntryFitness();
+    bool isEmpty();
+    int getSize();
+    int getInsertions();
+};
 
-    bool isOffScreen();
-    bool hasPassedBird(float birdXCordinate);
+struct NeatNodeGene
+{
+    int id;
+    int kind; // NEAT_INPUT, NEAT_BIAS, NEAT_OUTPUT or NEAT_HIDDEN
+};
 
-    float getXCordinate();
-    float getYcordinate();
-    float getWidth();
-    float getGapHeight();
+struct NeatConnectionGene
+{
+    int innovation;
+    int from;
+    int to;
+    float weight;
+    bool enabled;
+};
+
+class NeatInnovations
+{
+private:
+    // Same structural mutation in the same run gets the same number in every genome
+    std::map<std::pair<int, int>, int> connections;
+    std::map<int, int> splits;
+    int nextInnovation;
+    int nextNode;
+
+public:
+    NeatInnovations(int inputs, int outputs);
+
+    int getConnection(int from, int to);
+    int getSplitNode(int innovation);
+    int createNode();
+};
+
+class NeatGenome
+{
+private:
+    std::vector<NeatNodeGene> nodes;
+    std::vector<NeatConnectionGene> connections; // Sorted by innovation
+
+    bool hasNode(int id);
+    bool createsCycle(int from, int to);
+    void addConnection(NeatConnectionGene connection);
+
+public:
+    NeatGenome();
+    NeatGenome(int inputs, int outputs, NeatInnovations &innovations);
+
+    void mutate(NeatInnovations &innovations);
+    float distance(const NeatGenome &other);
+    static NeatGenome crossover(const NeatGenome &fitter, const NeatGenome &other);
+
+    const std::vector<NeatNodeGene> &getNodes() const;
+    const std::vector<NeatConnectionGene> &getConnections() const;
+    int getEnabledConnectionCount() const;
+};
+
+struct NeatInstruction
+{
+    int node;  // Slot written by this instruction
+    int begin; // Range of its incoming connections in sources / weights
+    int end;
+};
+
+class NeatNetwork
+{
+private:
+    NeatGenome genome;
+
+    // Compiled once per generation, nodes in topological order
+    int inputCount;
+    int valueCount;
+    std::vector<int> outputSlots;
+    std::vector<NeatInstruction> instructions;
+    std::vector<int> sources;
+    std::vector<float> weights;
+
+public:
+    NeatNetwork(const NeatGenome &genome);
+
+    std::vector<float> activate(const std::vector<float> &inputs) const;
+    const NeatGenome &getGenome() const;
+    int getConnectionCount() const;
+};
+
+class Optimiser
+{
+public:
+    virtual ~Optimiser() = default;
+
+    // Called once on the random initial population
+    virtual void initialise(std::vector<Bird> &birds) = 0;
+    // Called with every bird scored, writes the next generation's genomes into the birds
+    virtual void evolve(std::vector<Bird> &birds) = 0;
+    // Called after evolve with the same scored birds, writes another candidate generation into them
+    // without moving the optimiser's own state. The default suits optimisers that keep none
+    virtual void proposeOffspring(std::vector<Bird> &birds);
+    virtual const char *getName() = 0;
+    // Birds whose fitness ranks below this many others never become parents, 0 when every rank counts
+    virtual int getEliteCount();
+    // True when the birds fly an encoding only the optimiser can vary, so mutating their flat genome changes nothing
+    virtual bool ownsEncoding();
+    // Pool of the owner of the population, only used from inside initialise and evolve
+    virtual void setThreadPool(ThreadPool *pool);
+};
+
+class ElitistOptimiser : public Optimiser
+{
+private:
+    float mutationRate;
+
+public:
+    ElitistOptimiser(float mutationRate);
+
+    void initialise(std::vector<Bird> &birds) override;
+    void evolve(std::vector<Bird> &birds) override;
+    const char *getName() override;
+    int getEliteCount() override;
+};
+
+class OpenAIESOptimiser : public Optimiser
+{
+private:
+    std::vector<float> mean;
+    std::vector<float> adamM;
+    std::vector<float> adamV;
+    float sigma;
+    float learningRate;
+    float weightDecay;
+    int steps;
+
+    void sample(std::vector<Bird> &birds);
+
+public:
+    OpenAIESOptimiser(float sigma, float learningRate);
+
+    void initialise(std::vector<Bird> &birds) override;
+    void evolve(std::vector<Bird> &birds) override;
+    const char *getName() override;
+};
+
+class SepCMAESOptimiser : public Optimiser
+{
+private:
+    std::vector<float> mean;
+    std::vector<float> variance; // Diagonal of the covariance matrix
+    std::vector<float> pathSigma;
+    std::vector<float> pathC;
+    float sigma;
+    int generation;
+
+    void sample(std::vector<Bird> &birds);
+
+public:
+    SepCMAESOptimiser(float sigma);
+
+    void initialise(std::vector<Bird> &birds) override;
+    void evolve(std::vector<Bird> &birds) override;
+    const char *getName() override;
+};
+
+class NeatOptimiser : public Optimiser
+{
+private:
+    struct Species
+    {
+        int id;
+        NeatGenome representative;
+        std::vector<int> members;
+        int bestFitness;
+        int stagnation;
+    };
+
+    int inputs;
+    int outputs;
+    NeatInnovations innovations;
+    std::vector<Species> species;
+    float compatibilityThreshold;
+    int targetSpecies;
+    int nextSpeciesId;
+
+    void speciate(std::vector<NeatGenome> &genomes);
+
+public:
+    NeatOptimiser(int inputs, int outputs);
+
+    void initialise(std::vector<Bird> &birds) override;
+    void evolve(std::vector<Bird> &birds) override;
+    const char *getName() override;
+    bool ownsEncoding() override;
+};
+
+// Clusters the flat genomes with k-means every generation and breeds inside each cluster,
+// offspring shared out by mean species fitness so no single family takes over
+class SpeciesOptimiser : public Optimiser
+{
+private:
+    float mutationRate;
+    int speciesCount;
+    ThreadPool *pool; // nullptr clusters on the calling thread
+
+    int dimensions;
+    std::vector<float> centroids; // Row per species, the next generation starts from them
+    std::vector<int> labels; // Species of every bird of the last evolve, proposals breed from them again
+
+    void assign(const std::vector<float> &genomes, const std::vector<int> &points, std::vector<int> &labels);
+    void cluster(const std::vector<float> &genomes, int count, std::vector<int> &labels);
+    void breed(std::vector<Bird> &birds, int &alive, int &largest);
+
+public:
+    SpeciesOptimiser(float mutationRate, int speciesCount);
+
+    void initialise(std::vector<Bird> &birds) override;
+    void evolve(std::vector<Bird> &birds) override;
+    void proposeOffspring(std::vector<Bird> &birds) override;
+    const char *getName() override;
+    void setThreadPool(ThreadPool *pool) override;
+};
+
+std::unique_ptr<Optimiser> createOptimiser(const TrainingConfig &config);
+
+class KdTree
+{
+private:
+    struct Node
+    {
+        int point;
+        int axis;
+        int left;
+        int right;
+    };
+
+    int dimensions;
+    std::vector<float> points; // Row per point
+    std::vector<Node> nodes;
+    int root;
+    int balancedSize;
+
+    int build(std::vector<int> &order, int begin, int end, int depth);
+    void rebuild();
+    void search(int node, const float *query, int k, std::vector<std::pair<float, int>> &best);
+
+public:
+    KdTree(int dimensions);
+
+    void insert(const std::vector<float> &point);
+    // Euclidean distances to the k nearest points, closest first
+    std::vector<float> nearestDistances(const std::vector<float> &query, int k);
+    int getSize();
+};
+
+class NoveltySearch
+{
+private:
+    KdTree archive;
+    int neighbours;
+    float archiveRate;
+
+public:
+    NoveltySearch(int neighbours, float archiveRate);
+
+    // Replaces each bird's fitness with its novelty against the archive and its own generation
+    void score(std::vector<Bird> &birds);
+    int getArchiveSize();
+};
+
+// Online ridge regression from flat genome to fitness, older generations fade out
+class SurrogateModel
+{
+private:
+    int dimensions; // Genome size plus the bias feature
+    double ridge;
+    double forgetting;
+    std::vector<double> gram;   // Sum of x x^T, row-major
+    std::vector<double> moments; // Sum of y x
+    std::vector<float> weights;
+    int samples;
+
+public:
+    SurrogateModel(int genomeSize, double ridge, double forgetting);
+
+    void train(std::vector<Bird> &birds);
+    float predict(Bird &bird);
+    bool isReady();
 };
 
 class Population
 {
 private:
     std::vector<Bird> population;
+    BirdStates states; // Flight state of every slot, stepped by the simulation
     int generationNumber;
     float mutationRate;
     int populationSize;
 
+    EliteArchive archive;
+    int births;
+
+    std::unique_ptr<Optimiser> optimiser;
+    std::unique_ptr<NoveltySearch> novelty;
+
+    // Fitness by (genome hash, evaluation seed), only valid while episodes are deterministic
+    bool cacheEnabled;
+    std::unordered_map<Uint64, int> fitnessCache;
+    std::vector<Bird> cachedBirds;
+    int cacheHits;
+    int cacheLookups; // A slot is looked up again after each hit, so hits are a share of these
+
+    // Double-buffered block storage : one generation allocates while the previous one drains
+    GenomeArena *arenas[2];
+    int currentArena;
+
+    bool diversityEnabled;
+    void logDiversity();
+
+    std::unique_ptr<SurrogateModel> surrogate;
+    float surrogateFraction;
+    std::vector<float> predictions; // Surrogate score of each bird sent to simulation
+    void evolveWithSurrogate();
+
+    static Uint64 cacheKey(Uint64 genomeHash, unsigned int seed);
+
 public:
-    Population(int size, float mRate);
+    Population(int size, float mRate, int archiveSize = 10);
+    Population(const TrainingConfig &config);
+    Population(const Population &) = delete;
+    Population &operator=(const Population &) = delete;
+    ~Population();
     void evolveNewGeneration();
+    int refillDeadBirds();
+    void immigrate(const Bird &migrant);
+    Bird &getBestBird();
     std::vector<Bird> &getPopulation();
+    BirdStates &getStates();
     int getGenerationNumber();
+    EliteArchive &getArchive();
+    int getBirths();
+    Optimiser &getOptimiser();
+    int getEliteThreshold();
+
+    int applyFitnessCache(unsigned int seed);
+    void storeFitness(unsigned int seed);
+    float getCacheHitRate();
+};
+
+// Run-wide tally of early stops, shared by every simulation so parallel episodes add up
+class TerminationStats
+{
+private:
+    SDL_Mutex *mutex;
+    std::map<std::string, std::pair<int, double>> stops; // Policy -> birds stopped, bird-seconds saved
+
+public:
+    TerminationStats();
+    ~TerminationStats();
+
+    void record(const char *policy, int birds, double secondsSaved);
+    void log(const char *owner);
+};
+
+// Decides when a bird stops flying before it crashes on its own
+class TerminationPolicy
+{
+protected:
+    int horizonFrames; // Frame cap of the episode, savings are counted up to it
+
+public:
+    TerminationPolicy(int horizonFrames);
+    virtual ~TerminationPolicy() = default;
+
+    virtual const char *getName() = 0;
+    // Called once per episode before the first step
+    virtual void reset();
+    // Called before every step with the flock size, so per-slot state never grows while birds run in parallel
+    virtual void prepare(int slots);
+    // Called for every bird still flying after its update, index is its slot in the flock
+    virtual bool shouldStop(const BirdStates &states, int index, float deltaTime) = 0;
+    // Flight time the stop spared, taken as the time left until the frame cap
+    virtual double getSecondsSaved(const BirdStates &states, int index, float deltaTime);
+};
+
+// Nothing bounds how long a bird alive at the cap would have gone on, so the cap claims no savings
+class EpisodeLengthPolicy : public TerminationPolicy
+{
+public:
+    EpisodeLengthPolicy(int maxFrames);
+
+    const char *getName() override;
+    bool shouldStop(const BirdStates &states, int index, float deltaTime) override;
+};
+
+class NoProgressPolicy : public TerminationPolicy
+{
+private:
+    float maxSeconds;
+    // Per slot : score last seen, frame it was reached, so refilled slots are detected
+    std::vector<int> lastScore;
+    std::vector<int> progressFrame;
+
+public:
+    NoProgressPolicy(int horizonFrames, float maxSeconds);
+
+    const char *getName() override;
+    void reset() override;
+    void prepare(int slots) override;
+    bool shouldStop(const BirdStates &states, int index, float deltaTime) override;
+};
+
+class DominancePolicy : public TerminationPolicy
+{
+private:
+    int eliteThreshold; // Lowest fitness that still enters the elite set, 0 while unknown
+
+public:
+    DominancePolicy(int horizonFrames);
+
+    const char *getName() override;
+    bool shouldStop(const BirdStates &states, int index, float deltaTime) override;
+    void setEliteThreshold(int threshold);
+};
+
+// Totals of one simulation step
+struct StepStats
+{
+    int aliveBirds = 0;
+    int flaps = 0;
+    int crashes = 0; // Birds that hit a pipe, the roof or the ground this step
+    int stopped = 0; // Birds ended by a termination policy this step
+};
+
+// Results of one chunk of birds, reduced in chunk order so the outcome never depends on scheduling
+struct alignas(64) StepChunk
+{
+    StepStats stats;
+    std::vector<int> stopped; // Per policy
+    std::vector<double> secondsSaved;
+    std::vector<std::vector<double>> rays;
+};
+
+// Per-thread buffers, padded so threads never write to the same cache line
+struct alignas(64) StepScratch
+{
+    std::vector<float> input;
+};
+
+// What one reset or step hands back, pointing straight into the environment's buffers.
+// Rows are indexed by slot and stay valid until the next call that changes them
+struct EnvStep
+{
+    const float *observations; // slotCount rows of observationSize ray lengths
+    const float *rewards;      // Fitness gained this step, 0 for slots that did not fly
+    const Uint8 *dones;        // 1 once a slot has stopped, padding slots are always done
+    int slotCount;
+    int observationSize;
+};
+
+// A stretch of one step during which a pipe overlaps the birds' column and its gap moves in a straight line.
+// Times are seconds into the step
+struct GapSegment
+{
+    float begin;
+    float end;
+    float gap; // Gap centre at begin
+    float gapVelocity;
+};
+
+// The game without the networks : reset with a seed, step with one flap decision per slot, read back
+// observations, rewards and dones. Runs N environments at once, environment e flying slots
+// [e * stride, e * stride + birdsPerEnvironment) with stride rounded up to whole bitset words
+class FlappyEnv
+{
+private:
+    int environmentCount;
+    int birdsPerEnvironment;
+    int stride;
+    int slotCount;
+    float timeStep;
+
+    BirdStates ownStates; // Unused when the caller hands in its own store
+    BirdStates &states;
+
+    int windowWidth;
+    int windowHeight;
+    float roofHeight;
+    float groundHeight;
+
+    // Environment e owns a ring of VEC_ENV_PIPES slots from e * VEC_ENV_PIPES. Pipes are numbered in spawn order and
+    // pipe n keeps slot n % VEC_ENV_PIPES for its whole life, so spawning and retiring only move the counters.
+    // A pipe is closed-form in time : x falls linearly from its spawn time and the gap follows a triangle wave from
+    // its starting phase, so any moment can be queried without stepping through the ones before it
+    std::vector<double> pipeSpawnTime;
+    std::vector<float> pipePhase; // How far the gap had travelled down from its highest point when it spawned
+    std::vector<int> pipeFirst;   // Number of the oldest pipe still on screen
+    std::vector<int> pipeCount;
+    std::vector<int> pipeUnpassed; // Number of the first pipe whose right edge has not crossed the birds yet
+
+    std::vector<std::mt19937> pipeRandom; // Own stream per environment, so a seed fixes its pipe sequence
+    std::vector<unsigned int> seeds;
+    int frames;
+    double time; // Of the frame the birds are in
+    double previousTime;
+
+    // Pipes are looked up one step ahead of the birds, so observations already see the pipes of the next step
+    std::vector<PipeView> nearest; // Per environment, for the next step
+    std::vector<Uint8> pipePassed; // Pipes the birds pass during the next step
+    std::vector<Uint8> flownPassed; // Per environment, for the step being taken
+    // The pipes the birds can hit during the step being taken, environment e owning [segmentBegin[e], segmentBegin[e + 1])
+    std::vector<GapSegment> segments;
+    std::vector<int> segmentBegin;
+
+    std::vector<float> observations;
+    std::vector<float> rewards;
+    std::vector<Uint8> dones;
+    std::vector<int> rewardedWords; // Words whose rewards were written last step
+
+    std::vector<std::unique_ptr<TerminationPolicy>> policies;
+    DominancePolicy *dominance;
+    TerminationStats *terminationStats;
+
+    ThreadPool *pool; // nullptr steps the birds on the calling thread
+    std::vector<StepChunk> chunks;
+    StepStats stepStats;
+    bool collectRays;
+    std::vector<std::vector<double>> rays;
+
+    void resize(int birdsPerEnvironment);
+    int getPipeSlot(int environment, int pipe);
+    void spawnPipe(int environment);
+    void retirePipe(int environment);
+    float getPipeX(int slot, double time);
+    float getPipeGap(int slot, double time);
+    // Distance along the gap's round trip from its highest point, in [0, 2 * range)
+    double getGapTravel(int slot, double time);
+    // Splits the gap of every pipe crossing the birds' column during the step being taken into straight pieces
+    void sweepPipes();
+    // Spawns the pipes due by the given time and finds the pipe each environment's birds will face then
+    void advancePipes(double time);
+    PipeView makeView(float xCordinate, float yCordinateGap);
+    void observe(int slot, const PipeView &view, StepChunk *chunk);
+    void observeAll();
+    void stepChunk(int chunk, const Uint8 *actions);
+
+public:
+    FlappyEnv(int environmentCount, int birdsPerEnvironment, float timeStep = 1.0f / 60.0f);
+    // Steps the slots of a store the caller owns, the store must outlive the environment
+    FlappyEnv(BirdStates &states, int environmentCount, int birdsPerEnvironment, float timeStep, int windowWidth, int windowHeight, float roofHeight, float groundHeight);
+    FlappyEnv(const FlappyEnv &) = delete;
+    FlappyEnv &operator=(const FlappyEnv &) = delete;
+
+    void configureTermination(const TrainingConfig &config, TerminationStats *stats);
+    void setEliteThreshold(int threshold);
+    // Splits every step's slot loop across the pool, the pool must outlive the environment
+    void setThreadPool(ThreadPool *pool);
+    void setTimeStep(float timeStep);
+    // Keeps the rays of the last observations for drawing
+    void setRayCollection(bool enabled);
+    // Every slot starts over, the pipes carry on
+    void setBirdsPerEnvironment(int birdsPerEnvironment);
+
+    // Environment e draws its pipes from seed + e * 7919, so environment 0 replays a single game of the same seed
+    EnvStep reset(unsigned int seed);
+    // One seed per environment
+    EnvStep reset(const std::vector<unsigned int> &seeds);
+    // actions holds one byte per slot, non-zero flaps. Slots that are done ignore their action
+    EnvStep step(const Uint8 *actions);
+    // Puts one slot back at the start mid-episode and observes it, for steady-state refills
+    void resetSlot(int slot);
+    // The buffers of the last reset or step
+    EnvStep getLastStep();
+
+    int getEnvironmentCount();
+    int getBirdsPerEnvironment();
+    int getStride();
+    int getSlotCount();
+    int getFrames();
+    double getTime();
+    unsigned int getSeed(int environment);
+    float getTimeStep();
+    bool isDone(int slot);
+    int getAliveCount(int environment);
+    BirdStates &getStates();
+    const StepStats &getStepStats();
+    const std::vector<std::vector<double>> &getRays();
+
+    int getPipeCount(int environment);
+    // Pipe k of an environment, oldest first, at any moment of the episode
+    PipeView getPipeViewAt(int environment, int k, double time);
+    // Pipe k between the last two frames the birds were in, alpha as for BirdStates
+    PipeView getPipeView(int environment, int k, float alpha);
+};
+
+// Drives a FlappyEnv with the flock's networks and writes each flight back to its Bird
+class Simulation
+{
+private:
+    std::vector<Bird> &birds;
+    FlappyEnv environment;
+
+    ThreadPool *pool;
+    std::vector<StepScratch> scratch;
+    std::vector<Uint8> actions;
+    std::vector<int> flyingWords; // Live words before the step, with their bits
+    std::vector<Uint64> flyingBits;
+
+    void chooseActions();
+    void recordFlights();
+
+public:
+    Simulation(std::vector<Bird> &birds, BirdStates &states, int windowWidth, int windowHeight, float roofHeight, float groundHeight);
+    // birds holds one entry per slot of the environment, padding slots included
+    Simulation(std::vector<Bird> &birds, BirdStates &states, int environmentCount, int birdsPerEnvironment, int windowWidth, int windowHeight, float roofHeight, float groundHeight);
+
+    // Upper bound on the fitness a bird can still gain in the given number of frames
+    static int getFitnessGainBound(int frames, float deltaTime);
+
+    void configureTermination(const TrainingConfig &config, TerminationStats *stats);
+    void setEliteThreshold(int threshold);
+    // Splits every step's bird loop across the pool, the pool must outlive the simulation
+    void setThreadPool(ThreadPool *pool);
+
+    void reset();
+    void reset(unsigned int seed);
+    void reset(const std::vector<unsigned int> &seeds);
+    bool step(float deltaTime, std::vector<std::vector<double>> *rayCollection);
+    void runEpisode(float deltaTime, int maxEpisodeFrames);
+    void runEpisode(float deltaTime, int maxEpisodeFrames, unsigned int seed);
+    void runEpisode(float deltaTime, int maxEpisodeFrames, const std::vector<unsigned int> &seeds);
+    // Writes the state of the birds still flying back to them, stopped birds are written when they stop
+    void storeResults();
+
+    FlappyEnv &getEnvironment();
+    int getSurvivalFrames();
+    unsigned int getSeed();
+    const StepStats &getStepStats();
+};
+
+// N independent games stepped in lockstep, each with its own copy of the flock, pipe stream and seed
+class VecEnv
+{
+private:
+    std::vector<Bird> birds; // One per slot, padding slots never fly
+    BirdStates states;
+    Simulation simulation;
+
+public:
+    VecEnv(const std::vector<Bird> &flock, int environmentCount, int windowWidth, int windowHeight, float roofHeight, float groundHeight);
+
+    void configureTermination(const TrainingConfig &config, TerminationStats *stats);
+    void setThreadPool(ThreadPool *pool);
+
+    // One seed per environment
+    void reset(const std::vector<unsigned int> &seeds);
+    bool step(float deltaTime);
+    void runEpisode(float deltaTime, int maxEpisodeFrames, const std::vector<unsigned int> &seeds);
+    void storeResults();
+
+    Bird &getBird(int environment, int index);
+    int getEnvironmentCount();
+    int getBirdsPerEnvironment();
+    int getAliveCount(int environment);
+    const StepStats &getStepStats();
+    int getFrames();
+};
+
+class ThreadPool
+{
+private:
+    // Range of task indices a thread owns, taken from the front by its owner and from the back by thieves
+    struct alignas(64) WorkQueue
+    {
+        SDL_SpinLock lock;
+        int begin;
+        int end;
+    };
+
+    std::vector<SDL_Thread *> threads;
+    std::vector<WorkQueue> queues; // Slot 0 belongs to the thread calling parallelFor
+    SDL_Mutex *mutex;
+    SDL_Condition *wake;
+    SDL_Condition *done;
+    SDL_AtomicInt nextWorker;
+
+    const std::function<void(int, int)> *task; // nullptr between jobs
+    int generation; // Bumped by every job so sleeping threads know there is new work
+    int busy; // Threads still draining the current job
+    bool stopping;
+
+    static int threadEntry(void *data);
+    void work(int worker);
+    bool takeTask(int worker, int &index);
+    void drain(int worker, const std::function<void(int, int)> &current);
+
+public:
+    ThreadPool(int threadCount);
+    ~ThreadPool();
+
+    // Runs task(0 .. count - 1) across the pool and the calling thread, returns when all are done
+    void parallelFor(int count, const std::function<void(int)> &task);
+    // Same, also passing the slot of the running thread (0 .. getThreadCount() - 1) for per-thread scratch
+    void parallelFor(int count, const std::function<void(int, int)> &task);
+    int getThreadCount();
+};
+
+class MultiSeedEvaluator
+{
+private:
+    TrainingConfig config;
+    std::string aggregation;
+    float quantile;
+    float timeStep;
+    ThreadPool *pool; // The owner's, chunks of birds fly on it
+
+    int eliteCount;
+    TerminationStats termination;
+    long long steps;
+
+    int aggregate(std::vector<int> &scores);
+
+public:
+    MultiSeedEvaluator(const TrainingConfig &config, ThreadPool *pool, int eliteCount = 0);
+
+    // Every bird flies every seed, its fitness becomes the aggregate over the seeds
+    // With a dominance cutoff and mean aggregation, birds that can no longer reach the elite set skip the remaining seeds
+    void evaluate(std::vector<Bird> &birds, const std::vector<unsigned int> &seeds);
+
+    // The seeds of one generation follow from its first, so a worker process can rebuild them
+    static std::vector<unsigned int> getSeeds(unsigned int generationSeed, int count);
+
+    TerminationStats &getTerminationStats();
+    // Environment steps of the last evaluate, over every chunk and round
+    long long getSteps();
+};
+
+class MigrationQueue
+{
+private:
+    // Single producer / single consumer ring, one slot is always left empty
+    std::vector<Bird> slots;
+    SDL_AtomicInt head;
+    SDL_AtomicInt tail;
+
+public:
+    MigrationQueue(int capacity, const Bird &prototype);
+
+    bool push(const Bird &migrant);
+    bool pop(Bird &migrant);
+};
+
+class Island
+{
+private:
+    int id;
+    unsigned int seed;
+    int migrationInterval;
+    int maxGenerations;
+    int maxEpisodeFrames;
+    float timeStep;
+
+    Population population;
+    Simulation simulation;
+    TerminationStats termination;
+    ThreadPool pool; // Shared by the evaluator and the optimiser, which never run at once
+    int evaluationSeeds;
+    unsigned int evaluationSeed;
+    std::unique_ptr<MultiSeedEvaluator> evaluator;
+
+    MigrationQueue *inbox;
+    MigrationQueue *outbox;
+
+    SDL_Thread *thread;
+    SDL_AtomicInt generation;
+    SDL_AtomicInt bestFitness;
+    SDL_AtomicInt cacheHitRate; // Per mille, last generation
+    SDL_AtomicInt running;
+
+    static int threadEntry(void *data);
+    void evolve();
+
+public:
+    Island(int id, unsigned int seed, const TrainingConfig &config);
+
+    void connect(MigrationQueue *inbox, MigrationQueue *outbox);
+    void start();
+    void stop();
+    void join();
+
+    bool isRunning();
+    int getId();
+    int getGeneration();
+    int getBestFitness();
+    float getCacheHitRate();
+};
+
+class IslandModel
+{
+private:
+    TrainingConfig config;
+    std::vector<std::unique_ptr<Island>> islands;
+    std::vector<std::unique_ptr<MigrationQueue>> queues;
+
+public:
+    IslandModel(const TrainingConfig &config);
+
+    void run();
 };
 
 class Game
@@ -121,17 +1099,23 @@ private:
 
     int populationSize;
     float mutationRate;
+    bool steadyState;
+    bool headless;
+    int maxGenerations;
+    float timeStep; // Simulated seconds per physics step, independent of the frame rate
 
     Population population;
-    std::vector<Pipe> pipes;
-
-    float pipeSpawnTimer;
-    float PipeSpawnInterval;
+    Simulation simulation;
+    TerminationStats termination;
+    ThreadPool pool; // Steps the flock in parallel chunks
 
-    int survivalFrames;
+    // Headless generations with several seeds score every genome through this instead of the flock above
+    int evaluationSeeds;
+    unsigned int evaluationSeed;
+    std::unique_ptr<MultiSeedEvaluator> evaluator;
 
 public:
-    Game();
+    Game(const TrainingConfig &config);
 
     void resetGame();
     void run();
@@ -139,10 +1123,10 @@ public:
     void renderBackground();
     void renderRays(std::vector<std::vector<double>> rayCollection);
     void renderScore();
-    void renderPipes();
+    void renderPipes(float alpha);
     void renderRoof();
     void renderGround();
-    void renderBirds();
+    void renderBirds(float alpha);
 
     ~Game();
 };
@@ -155,4 +1139,41 @@ public:
     double endX, endY;
 };
 
+class WorkerPool
+{
+private:
+    struct WorkerProcess
+    {
+        SDL_Process *process = nullptr;
+        std::vector<Uint8> request;
+        size_t sent = 0;
+        std::vector<Uint8> response;
+        size_t received = 0;
+        int batchStart = -1;
+        int batchCount = 0;
+    };
+
+    TrainingConfig config;
+    Population population;
+    std::vector<WorkerProcess> workers;
+    ThreadPool pool; // The coordinator only flies birds itself when no worker starts, it keeps to its own thread
+    std::unique_ptr<MultiSeedEvaluator> evaluator; // Only for that fallback, workers rebuild the seeds themselves
+
+    int restarts;
+    Uint64 genomesEvaluated;
+
+    bool spawn(WorkerProcess &worker);
+    void retire(WorkerProcess &worker);
+    void evaluateGeneration(unsigned int seed);
+
+public:
+    WorkerPool(const TrainingConfig &config);
+    ~WorkerPool();
+
+    void run();
+};
+
+// Entry point of a process spawned by WorkerPool, talks binary over stdin / stdout
+int runEvaluationWorker();
+
 #endif
\ No newline at end of file
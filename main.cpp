@@ -1,17 +1,190 @@
 #include <iostream>
 #include <windows.h>
+#include <cstring>
+#include <ctime>
+#include <io.h>
+#include <fcntl.h>
 
 #include "Game/Game.h"
 
-int main()
+// Usage : main.exe [--headless] [--tick-rate HZ] [--islands N] [--migration M] [--generations G] [--population P] [--seed S]
+//                  [--workers N] [--batch B] [--steady-state] [--archive K]
+//                  [--optimiser elitist|openai-es|sep-cma-es|neat|species] [--species K] [--diversity]
+//                  [--sigma S] [--learning-rate L]
+//                  [--seeds K] [--aggregation mean|min|quantile] [--quantile Q] [--threads T]
+//                  [--novelty] [--novelty-k K] [--novelty-archive-rate R]
+//                  [--eval-seed S] [--fitness-cache]
+//                  [--max-frames F] [--no-progress SECONDS] [--dominance-cutoff] [--delta-genomes]
+//                  [--surrogate FRACTION]
+TrainingConfig parseArguments(int argc, char *argv[])
+{
+    TrainingConfig config;
+    config.executablePath = argv[0];
+    bool maxFramesGiven = false;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        bool hasValue = i + 1 < argc;
+
+        if (!strcmp(argv[i], "--islands") && hasValue)
+            config.islands = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--headless"))
+            config.headless = true;
+        else if (!strcmp(argv[i], "--tick-rate") && hasValue)
+            config.tickRate = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--migration") && hasValue)
+            config.migrationInterval = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--generations") && hasValue)
+            config.maxGenerations = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--population") && hasValue)
+            config.populationSize = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--seed") && hasValue)
+            config.seed = (unsigned int)strtoul(argv[++i], NULL, 10);
+        else if (!strcmp(argv[i], "--workers") && hasValue)
+            config.workers = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--batch") && hasValue)
+            config.batchSize = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--steady-state"))
+            config.steadyState = true;
+        else if (!strcmp(argv[i], "--archive") && hasValue)
+            config.archiveSize = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--optimiser") && hasValue)
+            config.optimiser = argv[++i];
+        else if (!strcmp(argv[i], "--species") && hasValue)
+            config.species = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--diversity"))
+            config.diversity = true;
+        else if (!strcmp(argv[i], "--surrogate") && hasValue)
+            config.surrogateFraction = (float)atof(argv[++i]);
+        else if (!strcmp(argv[i], "--sigma") && hasValue)
+            config.sigma = (float)atof(argv[++i]);
+        else if (!strcmp(argv[i], "--learning-rate") && hasValue)
+            config.learningRate = (float)atof(argv[++i]);
+        else if (!strcmp(argv[i], "--seeds") && hasValue)
+            config.evaluationSeeds = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--aggregation") && hasValue)
+            config.aggregation = argv[++i];
+        else if (!strcmp(argv[i], "--quantile") && hasValue)
+            config.quantile = (float)atof(argv[++i]);
+        else if (!strcmp(argv[i], "--threads") && hasValue)
+            config.threads = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--novelty"))
+            config.novelty = true;
+        else if (!strcmp(argv[i], "--novelty-k") && hasValue)
+            config.noveltyNeighbours = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--novelty-archive-rate") && hasValue)
+            config.noveltyArchiveRate = (float)atof(argv[++i]);
+        else if (!strcmp(argv[i], "--eval-seed") && hasValue)
+            config.evaluationSeed = (unsigned int)strtoul(argv[++i], NULL, 10);
+        else if (!strcmp(argv[i], "--fitness-cache"))
+            config.fitnessCache = true;
+        else if (!strcmp(argv[i], "--max-frames") && hasValue)
+        {
+            config.maxEpisodeFrames = atoi(argv[++i]);
+            maxFramesGiven = true;
+        }
+        else if (!strcmp(argv[i], "--no-progress") && hasValue)
+            config.noProgressSeconds = (float)atof(argv[++i]);
+        else if (!strcmp(argv[i], "--dominance-cutoff"))
+            config.dominanceCutoff = true;
+        else if (!strcmp(argv[i], "--delta-genomes"))
+            config.deltaGenomes = true;
+        else if (!strcmp(argv[i], "--worker"))
+            config.worker = true;
+        else
+            printf("Ignoring unknown argument : %s\n", argv[i]);
+    }
+
+    // Nobody watches the runs without a window, a bird that never crashes would hold its generation forever
+    if (!maxFramesGiven && (config.headless || config.islands > 0 || config.workers > 0))
+        config.maxEpisodeFrames = 60 * 60;
+
+    return config;
+}
+
+// Refuses flag combinations the selected mode would otherwise silently ignore
+bool validateConfig(const TrainingConfig &config)
+{
+    bool valid = true;
+
+    if (config.steadyState)
+    {
+        // Steady state never reaches a generation barrier, everything that runs there is lost
+        if (config.optimiser == "neat" || config.optimiser == "species")
+        {
+            printf("--steady-state cannot breed with the %s optimiser, it only evolves at a generation barrier\n", config.optimiser.c_str());
+            valid = false;
+        }
+        if (config.novelty || config.diversity || config.surrogateFraction > 0.0f)
+        {
+            printf("--steady-state cannot be combined with --novelty, --diversity or --surrogate, they run at a generation barrier\n");
+            valid = false;
+        }
+        if (config.optimiser == "openai-es" || config.optimiser == "sep-cma-es")
+            printf("--steady-state never updates the %s distribution, refills mutate archived birds like the elitist optimiser\n", config.optimiser.c_str());
+    }
+
+    if (config.steadyState && config.fitnessCache)
+    {
+        printf("--fitness-cache needs generational training, steady state never scores a whole generation\n");
+        valid = false;
+    }
+
+    if (config.evaluationSeeds > 1)
+    {
+        // The windowed game and steady state fly one shared flock, a genome never gets a second episode
+        if (config.steadyState || !(config.headless || config.islands > 0 || config.workers > 0))
+        {
+            printf("--seeds needs generational training with --headless, --islands or --workers\n");
+            valid = false;
+        }
+    }
+
+    return valid;
+}
+
+int main(int argc, char *argv[])
 {
     SetConsoleOutputCP(CP_UTF8);
 
+    TrainingConfig config = parseArguments(argc, argv);
+
+    if (config.worker)
+    {
+        // stdout carries the binary protocol, so nothing else may be printed
+        _setmode(_fileno(stdin), _O_BINARY);
+        _setmode(_fileno(stdout), _O_BINARY);
+        return runEvaluationWorker();
+    }
+
+    if (!validateConfig(config))
+        return 1;
+
     printf("Training Started!...\n");
 
-    Game game;
-    game.run();
+    if (config.workers > 0)
+    {
+        // The coordinator builds its population on construction, so the seed has to come first
+        seedRandom(config.seed ? config.seed : static_cast<unsigned int>(time(NULL)));
+
+        WorkerPool pool(config);
+        pool.run();
+    }
+    else if (config.islands > 0)
+    {
+        IslandModel model(config);
+        model.run();
+    }
+    else
+    {
+        // Seeded before the game builds its population, so with the fixed step a seed replays the whole run
+        if (config.seed)
+            seedRandom(config.seed);
+
+        Game game(config);
+        game.run();
+    }
 
     printf("Training Stopped!...\n");
     return 0;
-}
\ No newline at end of file
+}